@@ -55,11 +55,30 @@ cbuffer cbPass : register(b2)
     Light gLights[MaxLights];
 };
  
+#ifdef PACKED_VERTICES
+// Positions are snorms in the bounds of the mesh (gWorld starts with the dequantize transform),
+// normals are folded onto an octahedron
+struct VertexIn
+{
+	float4 PosL    : POSITION;
+    float2 NormalL : NORMAL;
+};
+
+float3 UnpackUnitVector(float2 packed)
+{
+    float3 v = float3(packed, 1.0f - abs(packed.x) - abs(packed.y));
+    if (v.z < 0.0f)
+        v.xy = (1.0f - abs(v.yx)) * (v.xy >= 0.0f ? 1.0f : -1.0f);
+
+    return normalize(v);
+}
+#else
 struct VertexIn
 {
 	float3 PosL    : POSITION;
     float3 NormalL : NORMAL;
 };
+#endif
 
 struct VertexOut
 {
@@ -73,11 +92,19 @@ VertexOut VS(VertexIn vin)
 	VertexOut vout = (VertexOut)0.0f;
 	
     // Transform to world space.
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+#ifdef PACKED_VERTICES
+    float3 posL = vin.PosL.xyz;
+    float3 normalL = UnpackUnitVector(vin.NormalL);
+#else
+    float3 posL = vin.PosL;
+    float3 normalL = vin.NormalL;
+#endif
+
+    float4 posW = mul(float4(posL, 1.0f), gWorld);
     vout.PosW = posW.xyz;
 
     // Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-    vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
+    vout.NormalW = mul(normalL, (float3x3)gWorld);
 
     // Transform to homogeneous clip space.
     vout.PosH = mul(posW, gViewProj);
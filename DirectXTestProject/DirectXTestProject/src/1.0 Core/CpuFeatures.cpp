@@ -0,0 +1,80 @@
+#include "CpuFeatures.h"
+
+#if CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if CPU_X86
+static void CpuId(int leaf, int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, leaf, subLeaf);
+	for (int i = 0; i < 4; ++i)
+		regs[i] = (unsigned int)info[i];
+#else
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Returns which register states the OS saves on a context switch.
+// A CPU can support AVX while the OS doesn't, in which case we can't use it.
+static unsigned long long GetEnabledXStates()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+static CpuFeatures QueryCpuFeatures()
+{
+	CpuFeatures features;
+
+#if CPU_X86
+	unsigned int regs[4];
+	CpuId(0, 0, regs);
+	unsigned int maxLeaf = regs[0];
+
+	if (maxLeaf < 1)
+		return features;
+
+	CpuId(1, 0, regs);
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+
+	features.SSE41 = (regs[2] & (1u << 19)) != 0;
+
+	// XMM and YMM state (bits 1 and 2) need to be enabled for any AVX instruction,
+	// opmask and ZMM state (bits 5, 6 and 7) for AVX-512.
+	unsigned long long xstates = osxsave ? GetEnabledXStates() : 0;
+	bool ymmEnabled = (xstates & 0x06) == 0x06;
+	bool zmmEnabled = (xstates & 0xe6) == 0xe6;
+
+	features.AVX = ymmEnabled && (regs[2] & (1u << 28)) != 0;
+	features.FMA = features.AVX && (regs[2] & (1u << 12)) != 0;
+	features.F16C = features.AVX && (regs[2] & (1u << 29)) != 0;
+
+	if (maxLeaf >= 7)
+	{
+		CpuId(7, 0, regs);
+		features.AVX2 = features.AVX && (regs[1] & (1u << 5)) != 0;
+		features.AVX512F = zmmEnabled && (regs[1] & (1u << 16)) != 0;
+	}
+#endif
+
+	return features;
+}
+
+const CpuFeatures& CpuFeatures::Get()
+{
+	static const CpuFeatures features = QueryCpuFeatures();
+	return features;
+}
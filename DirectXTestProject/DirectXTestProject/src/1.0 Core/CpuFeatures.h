@@ -0,0 +1,32 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+// MSVC lets us use any intrinsic in any function, GCC and Clang need the
+// instruction set to be enabled on the function that uses it.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define CPU_TARGET(isa)
+#else
+#define CPU_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Kernels that have to give the same bits as their scalar code also need ExactFloatingPoint.h
+
+// The instruction sets supported by the CPU (and enabled by the OS) we are running on.
+// This is queried once and used to pick SIMD kernels at runtime,
+// so the same executable runs on any x86 CPU and uses the widest kernel available.
+struct CpuFeatures
+{
+	bool SSE41 = false;
+	bool AVX = false;
+	bool AVX2 = false;
+	bool FMA = false;
+	bool F16C = false;
+	bool AVX512F = false;
+
+	static const CpuFeatures& Get();
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+// Include after all other headers in the .cpp files whose SIMD kernels give the same bits as their scalar code.
+// The kernels do the same operations in the same order as the scalar code, but that only holds while the compiler
+// doesn't contract a multiply and an add of either into a fused multiply-add, this turns that off for the rest of the file.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
@@ -0,0 +1,395 @@
+#include "Fft.h"
+#include "CpuFeatures.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
+
+// Columns a task transforms at once (and rows TransformRows transposes at once)
+static const int s_ColumnsPerChunk = 32;
+
+// The four rows of a radix-4 butterfly and its twiddles.
+// The results of the rows b and d go to StoreB and StoreD, which swaps them for the forward transform.
+struct Radix4Butterfly
+{
+	float* Re[4];
+	float* Im[4];
+	float* StoreBRe;
+	float* StoreBIm;
+	float* StoreDRe;
+	float* StoreDIm;
+	float W1Re;
+	float W1Im;
+	float W2Re;
+	float W2Im;
+};
+
+typedef void(*Radix2Fn)(float*, float*, float*, float*, int, int);
+typedef void(*Radix4Fn)(const Radix4Butterfly&, int, int);
+
+// a, b = a + b, a - b (the twiddle of the first radix-2 stage is 1)
+static void Radix2Scalar(float* aRe, float* aIm, float* bRe, float* bIm, int columnBegin, int columnEnd)
+{
+	for (int column = columnBegin; column < columnEnd; ++column)
+	{
+		float ar = aRe[column];
+		float ai = aIm[column];
+		float br = bRe[column];
+		float bi = bIm[column];
+
+		aRe[column] = ar + br;
+		aIm[column] = ai + bi;
+		bRe[column] = ar - br;
+		bIm[column] = ai - bi;
+	}
+}
+
+// Two radix-2 stages: (a, b) and (c, d) with W_2m^j, then (a, c) with W_4m^j and (b, d) with W_4m^(j + m) = W_4m^j * (+-i).
+// Multiplying by +i gives p = b + i * W_4m^j * d and q = b - i * W_4m^j * d, the inverse transform stores p to b and q to d,
+// the forward one (-i) the other way round.
+static void Radix4Scalar(const Radix4Butterfly& butterfly, int columnBegin, int columnEnd)
+{
+	const float w1r = butterfly.W1Re;
+	const float w1i = butterfly.W1Im;
+	const float w2r = butterfly.W2Re;
+	const float w2i = butterfly.W2Im;
+
+	for (int column = columnBegin; column < columnEnd; ++column)
+	{
+		float ar = butterfly.Re[0][column];
+		float ai = butterfly.Im[0][column];
+		float br = butterfly.Re[1][column];
+		float bi = butterfly.Im[1][column];
+		float cr = butterfly.Re[2][column];
+		float ci = butterfly.Im[2][column];
+		float dr = butterfly.Re[3][column];
+		float di = butterfly.Im[3][column];
+
+		float tbr = w1r * br - w1i * bi;
+		float tbi = w1r * bi + w1i * br;
+		float tdr = w1r * dr - w1i * di;
+		float tdi = w1r * di + w1i * dr;
+
+		float a1r = ar + tbr;
+		float a1i = ai + tbi;
+		float b1r = ar - tbr;
+		float b1i = ai - tbi;
+		float c1r = cr + tdr;
+		float c1i = ci + tdi;
+		float d1r = cr - tdr;
+		float d1i = ci - tdi;
+
+		float tcr = w2r * c1r - w2i * c1i;
+		float tci = w2r * c1i + w2i * c1r;
+		tdr = w2r * d1r - w2i * d1i;
+		tdi = w2r * d1i + w2i * d1r;
+
+		butterfly.Re[0][column] = a1r + tcr;
+		butterfly.Im[0][column] = a1i + tci;
+		butterfly.Re[2][column] = a1r - tcr;
+		butterfly.Im[2][column] = a1i - tci;
+		butterfly.StoreBRe[column] = b1r - tdi;
+		butterfly.StoreBIm[column] = b1i + tdr;
+		butterfly.StoreDRe[column] = b1r + tdi;
+		butterfly.StoreDIm[column] = b1i - tdr;
+	}
+}
+
+#if CPU_X86
+CPU_TARGET("avx")
+static void Radix2AVX(float* aRe, float* aIm, float* bRe, float* bIm, int columnBegin, int columnEnd)
+{
+	int column = columnBegin;
+	for (; column + 8 <= columnEnd; column += 8)
+	{
+		__m256 ar = _mm256_loadu_ps(aRe + column);
+		__m256 ai = _mm256_loadu_ps(aIm + column);
+		__m256 br = _mm256_loadu_ps(bRe + column);
+		__m256 bi = _mm256_loadu_ps(bIm + column);
+
+		_mm256_storeu_ps(aRe + column, _mm256_add_ps(ar, br));
+		_mm256_storeu_ps(aIm + column, _mm256_add_ps(ai, bi));
+		_mm256_storeu_ps(bRe + column, _mm256_sub_ps(ar, br));
+		_mm256_storeu_ps(bIm + column, _mm256_sub_ps(ai, bi));
+	}
+
+	// Calling into the scalar code without a tail costs an AVX/SSE state transition per call
+	if (column < columnEnd)
+		Radix2Scalar(aRe, aIm, bRe, bIm, column, columnEnd);
+}
+
+CPU_TARGET("avx")
+static void Radix4AVX(const Radix4Butterfly& butterfly, int columnBegin, int columnEnd)
+{
+	const __m256 w1r = _mm256_set1_ps(butterfly.W1Re);
+	const __m256 w1i = _mm256_set1_ps(butterfly.W1Im);
+	const __m256 w2r = _mm256_set1_ps(butterfly.W2Re);
+	const __m256 w2i = _mm256_set1_ps(butterfly.W2Im);
+
+	int column = columnBegin;
+	for (; column + 8 <= columnEnd; column += 8)
+	{
+		__m256 ar = _mm256_loadu_ps(butterfly.Re[0] + column);
+		__m256 ai = _mm256_loadu_ps(butterfly.Im[0] + column);
+		__m256 br = _mm256_loadu_ps(butterfly.Re[1] + column);
+		__m256 bi = _mm256_loadu_ps(butterfly.Im[1] + column);
+		__m256 cr = _mm256_loadu_ps(butterfly.Re[2] + column);
+		__m256 ci = _mm256_loadu_ps(butterfly.Im[2] + column);
+		__m256 dr = _mm256_loadu_ps(butterfly.Re[3] + column);
+		__m256 di = _mm256_loadu_ps(butterfly.Im[3] + column);
+
+		__m256 tbr = _mm256_sub_ps(_mm256_mul_ps(w1r, br), _mm256_mul_ps(w1i, bi));
+		__m256 tbi = _mm256_add_ps(_mm256_mul_ps(w1r, bi), _mm256_mul_ps(w1i, br));
+		__m256 tdr = _mm256_sub_ps(_mm256_mul_ps(w1r, dr), _mm256_mul_ps(w1i, di));
+		__m256 tdi = _mm256_add_ps(_mm256_mul_ps(w1r, di), _mm256_mul_ps(w1i, dr));
+
+		__m256 a1r = _mm256_add_ps(ar, tbr);
+		__m256 a1i = _mm256_add_ps(ai, tbi);
+		__m256 b1r = _mm256_sub_ps(ar, tbr);
+		__m256 b1i = _mm256_sub_ps(ai, tbi);
+		__m256 c1r = _mm256_add_ps(cr, tdr);
+		__m256 c1i = _mm256_add_ps(ci, tdi);
+		__m256 d1r = _mm256_sub_ps(cr, tdr);
+		__m256 d1i = _mm256_sub_ps(ci, tdi);
+
+		__m256 tcr = _mm256_sub_ps(_mm256_mul_ps(w2r, c1r), _mm256_mul_ps(w2i, c1i));
+		__m256 tci = _mm256_add_ps(_mm256_mul_ps(w2r, c1i), _mm256_mul_ps(w2i, c1r));
+		tdr = _mm256_sub_ps(_mm256_mul_ps(w2r, d1r), _mm256_mul_ps(w2i, d1i));
+		tdi = _mm256_add_ps(_mm256_mul_ps(w2r, d1i), _mm256_mul_ps(w2i, d1r));
+
+		_mm256_storeu_ps(butterfly.Re[0] + column, _mm256_add_ps(a1r, tcr));
+		_mm256_storeu_ps(butterfly.Im[0] + column, _mm256_add_ps(a1i, tci));
+		_mm256_storeu_ps(butterfly.Re[2] + column, _mm256_sub_ps(a1r, tcr));
+		_mm256_storeu_ps(butterfly.Im[2] + column, _mm256_sub_ps(a1i, tci));
+		_mm256_storeu_ps(butterfly.StoreBRe + column, _mm256_sub_ps(b1r, tdi));
+		_mm256_storeu_ps(butterfly.StoreBIm + column, _mm256_add_ps(b1i, tdr));
+		_mm256_storeu_ps(butterfly.StoreDRe + column, _mm256_add_ps(b1r, tdi));
+		_mm256_storeu_ps(butterfly.StoreDIm + column, _mm256_sub_ps(b1i, tdr));
+	}
+
+	if (column < columnEnd)
+		Radix4Scalar(butterfly, column, columnEnd);
+}
+#endif
+
+static Radix2Fn GetRadix2Fn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX)
+		return &Radix2AVX;
+#endif
+
+	return &Radix2Scalar;
+}
+
+static Radix4Fn GetRadix4Fn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX)
+		return &Radix4AVX;
+#endif
+
+	return &Radix4Scalar;
+}
+
+static const Radix2Fn s_Radix2 = GetRadix2Fn();
+static const Radix4Fn s_Radix4 = GetRadix4Fn();
+
+// Copies rowCount rows of columnCount floats (rowStride apart) to the columns of a plane (with columnStride floats per row),
+// or back when toRows is set. Goes through the columns in blocks, so the lines of both sides stay in cache.
+static void TransposeRows(float* rows, int rowStride, float* columns, int columnStride, int columnCount, int rowCount, bool toRows)
+{
+	const int blockSize = 16;
+
+	for (int blockBegin = 0; blockBegin < columnCount; blockBegin += blockSize)
+	{
+		int blockEnd = std::min<int>(blockBegin + blockSize, columnCount);
+
+		for (int row = 0; row < rowCount; ++row)
+		{
+			float* rowValues = rows + row * rowStride;
+
+			if (toRows)
+			{
+				for (int column = blockBegin; column < blockEnd; ++column)
+					rowValues[column] = columns[column * columnStride + row];
+			}
+			else
+			{
+				for (int column = blockBegin; column < blockEnd; ++column)
+					columns[column * columnStride + row] = rowValues[column];
+			}
+		}
+	}
+}
+
+Fft::Fft(int size):
+	m_Size(size),
+	m_Log2Size(0)
+{
+	assert(size >= 2 && (size & (size - 1)) == 0);
+
+	while ((1 << m_Log2Size) < size)
+		++m_Log2Size;
+
+	m_BitReversed.resize(size);
+	for (int i = 0; i < size; ++i)
+	{
+		int reversed = 0;
+		for (int bit = 0; bit < m_Log2Size; ++bit)
+			reversed |= ((i >> bit) & 1) << (m_Log2Size - 1 - bit);
+
+		m_BitReversed[i] = reversed;
+	}
+
+	// The radix-4 stages start after the radix-2 one (if any), every stage covers 4 times the span of the previous one
+	const double pi = 3.14159265358979323846;
+
+	for (int m = (m_Log2Size & 1) ? 2 : 1; 4 * m <= size; m *= 4)
+	{
+		for (int j = 0; j < m; ++j)
+		{
+			m_Cos2.push_back((float)std::cos(pi * j / m));
+			m_Sin2.push_back((float)std::sin(pi * j / m));
+			m_Cos4.push_back((float)std::cos(pi * j / (2 * m)));
+			m_Sin4.push_back((float)std::sin(pi * j / (2 * m)));
+		}
+	}
+}
+
+int Fft::GetSize() const
+{
+	return m_Size;
+}
+
+void Fft::TransformColumns(float* re, float* im, int columnBegin, int columnEnd, bool inverse) const
+{
+	assert(columnBegin >= 0 && columnEnd <= m_Size);
+
+	this->Transform(re, im, m_Size, columnBegin, columnEnd, inverse);
+}
+
+void Fft::TransformRows(float* re, float* im, int rowBegin, int rowEnd, bool inverse) const
+{
+	assert(rowBegin >= 0 && rowEnd <= m_Size);
+
+	const int n = m_Size;
+	std::vector<float> scratchRe(n * s_ColumnsPerChunk);
+	std::vector<float> scratchIm(n * s_ColumnsPerChunk);
+
+	for (int chunkBegin = rowBegin; chunkBegin < rowEnd; chunkBegin += s_ColumnsPerChunk)
+	{
+		// Row chunkBegin + i becomes column i of the scratch plane
+		int chunkRows = std::min<int>(s_ColumnsPerChunk, rowEnd - chunkBegin);
+
+		TransposeRows(re + chunkBegin * n, n, scratchRe.data(), chunkRows, n, chunkRows, false);
+		TransposeRows(im + chunkBegin * n, n, scratchIm.data(), chunkRows, n, chunkRows, false);
+
+		this->Transform(scratchRe.data(), scratchIm.data(), chunkRows, 0, chunkRows, inverse);
+
+		TransposeRows(re + chunkBegin * n, n, scratchRe.data(), chunkRows, n, chunkRows, true);
+		TransposeRows(im + chunkBegin * n, n, scratchIm.data(), chunkRows, n, chunkRows, true);
+	}
+}
+
+void Fft::Transform2D(float* const* re, float* const* im, int count, bool inverse) const
+{
+	const int chunkCount = (m_Size + s_ColumnsPerChunk - 1) / s_ColumnsPerChunk;
+
+	// Every task transforms a chunk of columns (rows) of one of the planes
+	TaskScheduler::Get().ParallelFor(0, count * chunkCount, 1,
+		[this, re, im, chunkCount, inverse](int taskBegin, int taskEnd)
+	{
+		for (int task = taskBegin; task < taskEnd; ++task)
+		{
+			int plane = task / chunkCount;
+			int columnBegin = (task % chunkCount) * s_ColumnsPerChunk;
+			int columnEnd = std::min<int>(columnBegin + s_ColumnsPerChunk, m_Size);
+
+			this->TransformColumns(re[plane], im[plane], columnBegin, columnEnd, inverse);
+		}
+	});
+
+	TaskScheduler::Get().ParallelFor(0, count * chunkCount, 1,
+		[this, re, im, chunkCount, inverse](int taskBegin, int taskEnd)
+	{
+		for (int task = taskBegin; task < taskEnd; ++task)
+		{
+			int plane = task / chunkCount;
+			int rowBegin = (task % chunkCount) * s_ColumnsPerChunk;
+			int rowEnd = std::min<int>(rowBegin + s_ColumnsPerChunk, m_Size);
+
+			this->TransformRows(re[plane], im[plane], rowBegin, rowEnd, inverse);
+		}
+	});
+}
+
+void Fft::Transform(float* re, float* im, int stride, int columnBegin, int columnEnd, bool inverse) const
+{
+	const int n = m_Size;
+
+	for (int row = 0; row < n; ++row)
+	{
+		int reversed = m_BitReversed[row];
+		if (row >= reversed)
+			continue;
+
+		for (int column = columnBegin; column < columnEnd; ++column)
+		{
+			std::swap(re[row * stride + column], re[reversed * stride + column]);
+			std::swap(im[row * stride + column], im[reversed * stride + column]);
+		}
+	}
+
+	int m = 1;
+	if (m_Log2Size & 1)
+	{
+		for (int row = 0; row < n; row += 2)
+		{
+			s_Radix2(re + row * stride, im + row * stride, re + (row + 1) * stride, im + (row + 1) * stride,
+				columnBegin, columnEnd);
+		}
+
+		m = 2;
+	}
+
+	// The twiddles run counter clockwise for the inverse transform
+	const float sign = inverse ? 1.0f : -1.0f;
+
+	for (int twiddleOffset = 0; 4 * m <= n; twiddleOffset += m, m *= 4)
+	{
+		for (int group = 0; group < n; group += 4 * m)
+		{
+			for (int j = 0; j < m; ++j)
+			{
+				Radix4Butterfly butterfly;
+				for (int i = 0; i < 4; ++i)
+				{
+					butterfly.Re[i] = re + (group + j + i * m) * stride;
+					butterfly.Im[i] = im + (group + j + i * m) * stride;
+				}
+
+				int storeB = inverse ? 1 : 3;
+				int storeD = inverse ? 3 : 1;
+				butterfly.StoreBRe = butterfly.Re[storeB];
+				butterfly.StoreBIm = butterfly.Im[storeB];
+				butterfly.StoreDRe = butterfly.Re[storeD];
+				butterfly.StoreDIm = butterfly.Im[storeD];
+
+				butterfly.W1Re = m_Cos2[twiddleOffset + j];
+				butterfly.W1Im = sign * m_Sin2[twiddleOffset + j];
+				butterfly.W2Re = m_Cos4[twiddleOffset + j];
+				butterfly.W2Im = sign * m_Sin4[twiddleOffset + j];
+
+				s_Radix4(butterfly, columnBegin, columnEnd);
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+// Fast Fourier transform of a power-of-two size on split complex data (the real and the imaginary parts in separate arrays).
+// The transforms are unnormalized: the forward transform uses exp(-2 pi i jk / n), the inverse exp(+2 pi i jk / n)
+// and a forward transform followed by an inverse one scales the data by n (n * n for the 2D transforms).
+// The stages are radix-4 (two radix-2 stages fused, so every element is loaded and stored once per two stages),
+// plus a radix-2 stage for odd powers of two. Runs 8 columns per instruction with AVX, which gives the same results as the scalar path.
+class Fft
+{
+public:
+	explicit Fft(int size);
+
+	int GetSize() const;
+
+	// Transforms the columns [columnBegin, columnEnd) of a size x size plane (row major) in place
+	void TransformColumns(float* re, float* im, int columnBegin, int columnEnd, bool inverse) const;
+
+	// Transforms the rows [rowBegin, rowEnd) of a size x size plane in place.
+	// The rows are transposed into a scratch plane a few at a time and transformed as its columns.
+	void TransformRows(float* re, float* im, int rowBegin, int rowEnd, bool inverse) const;
+
+	// Transforms count size x size planes in place (columns, then rows), in parallel on the task scheduler
+	void Transform2D(float* const* re, float* const* im, int count, bool inverse) const;
+
+private:
+	// Transforms the columns [columnBegin, columnEnd) of size rows that are stride floats apart
+	void Transform(float* re, float* im, int stride, int columnBegin, int columnEnd, bool inverse) const;
+
+private:
+	int m_Size;
+	int m_Log2Size;
+
+	// Row each row swaps with for the bit reversed order
+	std::vector<int> m_BitReversed;
+
+	// Twiddles of the radix-4 stages, W_2m^j and W_4m^j (j < m) of stage m one after the other, as cos and sin of the angle
+	std::vector<float> m_Cos2;
+	std::vector<float> m_Sin2;
+	std::vector<float> m_Cos4;
+	std::vector<float> m_Sin4;
+};
@@ -16,7 +16,7 @@
 struct FrameResource
 {
 public:
-	FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount = 1, UINT waveVertCount = 1);
+	FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount = 1, UINT waveVertCount = 1, UINT oceanVertCount = 1);
 	FrameResource(const FrameResource& other) = delete;
 	FrameResource& operator=(const FrameResource& other) = delete;
 	~FrameResource();
@@ -40,6 +40,7 @@ public:
 
 	// Temp value for LightningWaves
 	std::unique_ptr<UploadBuffer<LightningVertex>> WavesVB = nullptr;
+	std::unique_ptr<UploadBuffer<LightningVertex>> OceanVB = nullptr;
 
 	// Frence value to mark commands up to this fence point.
 	// This lets us check if these frame resources are still in use by the GPU.
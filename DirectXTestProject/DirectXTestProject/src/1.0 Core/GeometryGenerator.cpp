@@ -1,6 +1,15 @@
 #include "GeometryGenerator.h"
+#include "CpuFeatures.h"
+#include "TaskScheduler.h"
 
 #include <algorithm>
+#include <cassert>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
 
 using namespace DirectX;
 
@@ -67,19 +76,6 @@ GeometryGenerator::Vertex& GeometryGenerator::Vertex::operator=(const GeometryGe
 	return *this;
 }
 
-
-std::vector<uint16_t>& GeometryGenerator::MeshData::GetIndices16()
-{
-	if (m_Indices16.empty())
-	{
-		m_Indices16.resize(Indices32.size());
-		for (size_t i = 0; i < Indices32.size(); ++i)
-			m_Indices16[i] = static_cast<uint16_t>(Indices32[i]);
-	}
-
-	return m_Indices16;
-}
-
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32_t numSubdivisions)
 {
 	MeshData meshData;
@@ -165,72 +161,200 @@ GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float heig
 	// Put a cap on the number of subdivisions.
 	numSubdivisions = std::min<uint32_t>(numSubdivisions, 6u);
 
+	// Every subdivision splits a triangle in 4, a face ends up with (2^n + 1)^2 vertices
+	uint32_t faceEdgeVertexCount = (1u << numSubdivisions) + 1;
+	meshData.Vertices.reserve(6 * faceEdgeVertexCount * faceEdgeVertexCount);
+	meshData.Indices32.reserve(36u << (2 * numSubdivisions));
+
 	for (uint32_t i = 0; i < numSubdivisions; ++i)
 		Subdivide(meshData);
 
 	return meshData;
 }
 
+typedef void(*GridColumnsFn)(float*, float*, float, float, float, int, int);
+typedef void(*OffsetIndicesFn)(uint32_t*, const uint32_t*, uint32_t, int);
+
+// The x and u of the columns [columnBegin, columnEnd) of a grid, they are the same for every row
+static void GridColumnsScalar(float* x, float* u, float halfWidth, float dx, float du, int columnBegin, int columnEnd)
+{
+	for (int j = columnBegin; j < columnEnd; ++j)
+	{
+		x[j] = -halfWidth + j * dx;
+		u[j] = j * du;
+	}
+}
+
+// destination[k] = pattern[k] + offset
+static void OffsetIndicesScalar(uint32_t* destination, const uint32_t* pattern, uint32_t offset, int count)
+{
+	for (int k = 0; k < count; ++k)
+		destination[k] = pattern[k] + offset;
+}
+
+#if CPU_X86
+CPU_TARGET("avx")
+static void GridColumnsAVX(float* x, float* u, float halfWidth, float dx, float du, int columnBegin, int columnEnd)
+{
+	const __m256 minusHalfWidth = _mm256_set1_ps(-halfWidth);
+	const __m256 dxs = _mm256_set1_ps(dx);
+	const __m256 dus = _mm256_set1_ps(du);
+	const __m256 eight = _mm256_set1_ps(8.0f);
+
+	// The column numbers stay exact in floats up to 2^24
+	__m256 js = _mm256_add_ps(_mm256_set1_ps((float)columnBegin), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+
+	int j = columnBegin;
+	for (; j + 8 <= columnEnd; j += 8)
+	{
+		_mm256_storeu_ps(x + j, _mm256_add_ps(minusHalfWidth, _mm256_mul_ps(js, dxs)));
+		_mm256_storeu_ps(u + j, _mm256_mul_ps(js, dus));
+		js = _mm256_add_ps(js, eight);
+	}
+
+	// Calling into the scalar code without a tail costs an AVX/SSE state transition per call
+	if (j < columnEnd)
+		GridColumnsScalar(x, u, halfWidth, dx, du, j, columnEnd);
+}
+
+CPU_TARGET("avx2")
+static void OffsetIndicesAVX2(uint32_t* destination, const uint32_t* pattern, uint32_t offset, int count)
+{
+	const __m256i offsets = _mm256_set1_epi32((int)offset);
+
+	int k = 0;
+	for (; k + 8 <= count; k += 8)
+	{
+		__m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + k));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + k), _mm256_add_epi32(indices, offsets));
+	}
+
+	if (k < count)
+		OffsetIndicesScalar(destination + k, pattern + k, offset, count - k);
+}
+#endif
+
+static GridColumnsFn GetGridColumnsFn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX)
+		return &GridColumnsAVX;
+#endif
+
+	return &GridColumnsScalar;
+}
+
+static OffsetIndicesFn GetOffsetIndicesFn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX2)
+		return &OffsetIndicesAVX2;
+#endif
+
+	return &OffsetIndicesScalar;
+}
+
+static const GridColumnsFn s_GridColumns = GetGridColumnsFn();
+static const OffsetIndicesFn s_OffsetIndices = GetOffsetIndicesFn();
+
 GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n)
 {
 	MeshData meshData;
 
-	uint32_t vertexCount = m * n;
-	uint32_t faceCount = (m - 1)*(n - 1) * 2;
+	meshData.Vertices.resize(GetGridVertexCount(m, n));
+	meshData.Indices32.resize(GetGridIndexCount(m, n));
 
-	// Create the vertices
+	this->CreateGrid(width, depth, m, n, meshData.Vertices.data(), meshData.Indices32.data());
 
-	float halfWidth = 0.5f * width;
-	float halfDepth = 0.5f * depth;
+	return meshData;
+}
 
-	float dx = width / (n - 1);
-	float dz = depth / (m - 1);
+void GeometryGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n, Vertex* vertices, uint32_t* indices)
+{
+	assert(m >= 2 && n >= 2);
 
-	float du = 1.0f / (n - 1);
-	float dv = 1.0f / (m - 1);
+	// ~16K vertices per task
+	int rowsPerChunk = std::max<int>(1, 16384 / (int)n);
 
-	meshData.Vertices.resize(vertexCount);
-	for (uint32_t i = 0; i < m; ++i)
+	// Create the vertices
+
+	if (vertices)
 	{
-		float z = halfDepth - i * dz;
-		for (uint32_t j = 0; j < n; ++j)
-		{
-			float x = -halfWidth + j * dx;
+		float halfWidth = 0.5f * width;
+		float halfDepth = 0.5f * depth;
 
-			meshData.Vertices[i*n + j].Position = XMFLOAT3(x, 0.0f, z);
-			meshData.Vertices[i*n + j].Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
-			meshData.Vertices[i*n + j].TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+		float dx = width / (n - 1);
+		float dz = depth / (m - 1);
 
-			// stretch texture over grid.
-			meshData.Vertices[i*n + j].TexC.x = j * du;
-			meshData.Vertices[i*n + j].TexC.y = i * dv;
-		}
+		float du = 1.0f / (n - 1);
+		float dv = 1.0f / (m - 1);
+
+		// x and u only depend on the column, z and v only on the row
+		std::vector<float> columnX(n);
+		std::vector<float> columnU(n);
+		s_GridColumns(columnX.data(), columnU.data(), halfWidth, dx, du, 0, (int)n);
+
+		TaskScheduler::Get().ParallelFor(0, (int)m, rowsPerChunk,
+			[&](int rowBegin, int rowEnd)
+		{
+			for (int i = rowBegin; i < rowEnd; ++i)
+			{
+				float z = halfDepth - i * dz;
+				float v = i * dv;
+
+				// Whole vertices are written in order, the destination can be write-combined upload memory.
+				// The texture is stretched over the grid.
+				Vertex vertex(0.0f, 0.0f, z, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, v);
+
+				Vertex* row = vertices + (size_t)i * n;
+				for (uint32_t j = 0; j < n; ++j)
+				{
+					vertex.Position.x = columnX[j];
+					vertex.TexC.x = columnU[j];
+					row[j] = vertex;
+				}
+			}
+		});
 	}
 
 	// Create the indices
 
-	// 3 indices per face
-	meshData.Indices32.resize(faceCount * 3);
-
-	// Iterate over each quad and copmute indices.
-	uint32_t k = 0;
-	for (uint32_t i = 0; i < m - 1; ++i)
+	if (indices)
 	{
+		// 2 faces of 3 indices per quad. Every row of quads has the indices of the first one, offset by n per row.
+		int rowIndexCount = 6 * (int)(n - 1);
+
+		std::vector<uint32_t> pattern(rowIndexCount);
 		for (uint32_t j = 0; j < n - 1; ++j)
 		{
-			meshData.Indices32[k] = i * n + j;
-			meshData.Indices32[k + 1] = i * n + j + 1;
-			meshData.Indices32[k + 2] = (i + 1)*n + j;
+			uint32_t* quad = &pattern[j * 6];
 
-			meshData.Indices32[k + 3] = (i + 1)*n + j;
-			meshData.Indices32[k + 4] = i * n + j + 1;
-			meshData.Indices32[k + 5] = (i + 1)*n + j + 1;
+			quad[0] = j;
+			quad[1] = j + 1;
+			quad[2] = n + j;
 
-			k += 6; // next quad
+			quad[3] = n + j;
+			quad[4] = j + 1;
+			quad[5] = n + j + 1;
 		}
+
+		TaskScheduler::Get().ParallelFor(0, (int)m - 1, rowsPerChunk,
+			[&](int rowBegin, int rowEnd)
+		{
+			for (int i = rowBegin; i < rowEnd; ++i)
+				s_OffsetIndices(indices + (size_t)i * rowIndexCount, pattern.data(), i * n, rowIndexCount);
+		});
 	}
+}
 
-	return meshData;
+uint32_t GeometryGenerator::GetGridVertexCount(uint32_t m, uint32_t n)
+{
+	return m * n;
+}
+
+uint32_t GeometryGenerator::GetGridIndexCount(uint32_t m, uint32_t n)
+{
+	return (m - 1)*(n - 1) * 6;
 }
 
 GeometryGenerator::MeshData GeometryGenerator::CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount)
@@ -355,7 +479,7 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeoSphere(float radius, uin
 	XMFLOAT3 pos[12] =
 	{
 		XMFLOAT3(-x, 0.0f, z), XMFLOAT3(x,  0.0f,  z),
-		XMFLOAT3(-x, 0.0f, z), XMFLOAT3(x,  0.0f, -z),
+		XMFLOAT3(-x, 0.0f, -z), XMFLOAT3(x,  0.0f, -z),
 		XMFLOAT3(0.0f, z,  x), XMFLOAT3(0.0f,  z, -x),
 		XMFLOAT3(0.0f, -z, x), XMFLOAT3(0.0f, -z, -x),
 		XMFLOAT3(z,  x, 0.0f), XMFLOAT3(-z,  x, 0.0f),
@@ -370,6 +494,10 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeoSphere(float radius, uin
 		10, 1, 6,	11, 0, 9,	2, 11, 9,	5, 2, 9,	11, 2, 7
 	};
 
+	// Every subdivision splits a triangle in 4, the welded sphere ends up with 10 * 4^n + 2 vertices
+	meshData.Vertices.reserve((10u << (2 * numSubdivisions)) + 2);
+	meshData.Indices32.reserve(60u << (2 * numSubdivisions));
+
 	meshData.Vertices.resize(12);
 	meshData.Indices32.assign(&k[0], &k[60]);
 
@@ -583,14 +711,89 @@ void GeometryGenerator::BuildCylinderBottomCap(float bottomRadius, float topRadi
 	}
 }
 
-void GeometryGenerator::Subdivide(MeshData& meshData)
+// The midpoints of the edges of a mesh, keyed by the pair of vertices of an edge (in either order),
+// so the triangles on both sides of an edge share its midpoint.
+// A flat open addressing table with linear probing, sized up front so it never grows.
+class EdgeMidpointMap
 {
-	// save a copy of the input geometry
-	MeshData inputCopy = meshData;
+public:
+	// Room for edgeCount edges, at most 3/4 full
+	explicit EdgeMidpointMap(uint32_t edgeCount)
+	{
+		uint32_t capacity = 16;
+		while (capacity < edgeCount + edgeCount / 3)
+			capacity *= 2;
 
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
+		m_Slots.assign(capacity, Slot{ s_EmptyKey, 0 });
+		m_Mask = capacity - 1;
+	}
+
+	// Returns the index of the midpoint of the edge (v0, v1), giving new edges nextIndex++
+	uint32_t Add(uint32_t v0, uint32_t v1, uint32_t& nextIndex)
+	{
+		uint64_t key = MakeKey(v0, v1);
 
+		Slot* slot = this->Find(key);
+		if (slot->Key == s_EmptyKey)
+		{
+			slot->Key = key;
+			slot->Index = nextIndex++;
+		}
+
+		return slot->Index;
+	}
+
+	// Returns the index of the midpoint of an edge that was added
+	uint32_t Get(uint32_t v0, uint32_t v1)
+	{
+		Slot* slot = this->Find(MakeKey(v0, v1));
+		assert(slot->Key != s_EmptyKey);
+
+		return slot->Index;
+	}
+
+	// Calls f(v0, v1, index) for every edge
+	template<typename TFunc>
+	void ForEach(TFunc f) const
+	{
+		for (const Slot& slot : m_Slots)
+		{
+			if (slot.Key != s_EmptyKey)
+				f((uint32_t)(slot.Key >> 32), (uint32_t)slot.Key, slot.Index);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	// No edge has the same vertex at both ends
+	static const uint64_t s_EmptyKey = ~0ull;
+
+	static uint64_t MakeKey(uint32_t v0, uint32_t v1)
+	{
+		return v0 < v1 ? ((uint64_t)v0 << 32) | v1 : ((uint64_t)v1 << 32) | v0;
+	}
+
+	Slot* Find(uint64_t key)
+	{
+		// Fibonacci hashing spreads the consecutive indices of neighbouring edges over the table
+		uint32_t idx = (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & m_Mask;
+		while (m_Slots[idx].Key != key && m_Slots[idx].Key != s_EmptyKey)
+			idx = (idx + 1) & m_Mask;
+
+		return &m_Slots[idx];
+	}
+
+	std::vector<Slot> m_Slots;
+	uint32_t m_Mask;
+};
+
+void GeometryGenerator::Subdivide(MeshData& meshData)
+{
 	//       v1
 	//       *
 	//      / \
@@ -601,45 +804,56 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32_t numTris = (uint32_t)inputCopy.Indices32.size() / 3;
+	// The corners keep their vertices and every edge gets a single midpoint, shared by the triangles on both sides,
+	// so the mesh stays welded: a closed mesh goes from V to V + 3T/2 vertices instead of 6T.
+	std::vector<Vertex>& vertices = meshData.Vertices;
+	std::vector<uint32_t>& indices = meshData.Indices32;
+
+	uint32_t numVertices = (uint32_t)vertices.size();
+	uint32_t numTris = (uint32_t)indices.size() / 3;
+
+	// Number the midpoints in the order the triangles reach them, that keeps them close to their neighbours
+	EdgeMidpointMap midpoints(3 * numTris);
+	uint32_t nextIndex = numVertices;
+
 	for (uint32_t i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 0]];
-		Vertex v1 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 1]];
-		Vertex v2 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 2]];
-
-		// Generate the midpoints
+		const uint32_t* tri = &indices[i * 3];
+		midpoints.Add(tri[0], tri[1], nextIndex);
+		midpoints.Add(tri[1], tri[2], nextIndex);
+		midpoints.Add(tri[2], tri[0], nextIndex);
+	}
 
-		Vertex m0 = MidPoint(v0, v1);
-		Vertex m1 = MidPoint(v1, v2);
-		Vertex m2 = MidPoint(v2, v0);
+	vertices.reserve(nextIndex);
+	vertices.resize(nextIndex);
 
-		// Add new geometry
+	midpoints.ForEach([this, &vertices](uint32_t v0, uint32_t v1, uint32_t index)
+	{
+		vertices[index] = MidPoint(vertices[v0], vertices[v1]);
+	});
 
-		meshData.Vertices.emplace_back(v0); // 0
-		meshData.Vertices.emplace_back(v1); // 1
-		meshData.Vertices.emplace_back(v2); // 2
-		meshData.Vertices.emplace_back(m0); // 3
-		meshData.Vertices.emplace_back(m1); // 4
-		meshData.Vertices.emplace_back(m2); // 5
+	// The 4 triangles of triangle i go to [12i, 12i + 12). Going from the last triangle to the first,
+	// they only ever overwrite triangles that were already split, so the indices are split in place.
+	indices.reserve(numTris * 12);
+	indices.resize(numTris * 12);
 
-		meshData.Indices32.emplace_back(i * 6 + 0);
-		meshData.Indices32.emplace_back(i * 6 + 3);
-		meshData.Indices32.emplace_back(i * 6 + 5);
+	for (uint32_t i = numTris; i-- > 0;)
+	{
+		uint32_t v0 = indices[i * 3 + 0];
+		uint32_t v1 = indices[i * 3 + 1];
+		uint32_t v2 = indices[i * 3 + 2];
 
-		meshData.Indices32.emplace_back(i * 6 + 3);
-		meshData.Indices32.emplace_back(i * 6 + 4);
-		meshData.Indices32.emplace_back(i * 6 + 5);
+		uint32_t m0 = midpoints.Get(v0, v1);
+		uint32_t m1 = midpoints.Get(v1, v2);
+		uint32_t m2 = midpoints.Get(v2, v0);
 
-		meshData.Indices32.emplace_back(i * 6 + 5);
-		meshData.Indices32.emplace_back(i * 6 + 4);
-		meshData.Indices32.emplace_back(i * 6 + 2);
+		uint32_t* out = &indices[i * 12];
 
-		meshData.Indices32.emplace_back(i * 6 + 3);
-		meshData.Indices32.emplace_back(i * 6 + 1);
-		meshData.Indices32.emplace_back(i * 6 + 4);
+		out[0] = v0; out[1] = m0; out[2] = m2;
+		out[3] = m0; out[4] = m1; out[5] = m2;
+		out[6] = m2; out[7] = m1; out[8] = v2;
+		out[9] = m0; out[10] = v1; out[11] = m1;
 	}
-
 }
 
 GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1)
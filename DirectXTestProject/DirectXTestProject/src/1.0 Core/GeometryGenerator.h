@@ -42,21 +42,25 @@ public:
 	struct MeshData
 	{
 		std::vector<Vertex> Vertices;
+		// Always 32 bit, IndexData takes them down to 16 bits for the index buffer when they fit
 		std::vector<uint32_t> Indices32;
-
-		std::vector<uint16_t>& GetIndices16();
-
-	private:
-		std::vector<uint16_t> m_Indices16;
 	};
 	
 	MeshData CreateBox(float width, float height, float depth, uint32_t numSubdivisions);
-	MeshData GeometryGenerator::CreateGrid(float width, float depth, uint32_t m, uint32_t n);
+	MeshData CreateGrid(float width, float depth, uint32_t m, uint32_t n);
+
+	// Writes the grid of CreateGrid straight into caller memory (e.g. a mapped upload buffer):
+	// GetGridVertexCount(m, n) vertices and GetGridIndexCount(m, n) indices, either can be nullptr to skip it.
+	// The rows are built in parallel, the positions and texture coordinates and the indices with SIMD.
+	void CreateGrid(float width, float depth, uint32_t m, uint32_t n, Vertex* vertices, uint32_t* indices);
+	static uint32_t GetGridVertexCount(uint32_t m, uint32_t n);
+	static uint32_t GetGridIndexCount(uint32_t m, uint32_t n);
+
 	MeshData CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount);
 	MeshData CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount);
 	MeshData CreateGeoSphere(float radius, uint32_t numSubdivisions);
 
-	void GeometryGenerator::Subdivide(MeshData& meshData);
+	void Subdivide(MeshData& meshData);
 	void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
 	void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount, MeshData& meshData);
 
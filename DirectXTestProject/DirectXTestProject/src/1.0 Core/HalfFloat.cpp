@@ -0,0 +1,138 @@
+#include "HalfFloat.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	bits &= 0x7fffffff;
+
+	uint16_t half;
+	if (bits >= 0x47800000) // Too big for a half (or already inf/nan)
+	{
+		half = bits > 0x7f800000 ? 0x7e00 : 0x7c00;
+	}
+	else if (bits < 0x38800000) // Denormal or zero as a half
+	{
+		// Adding 0.5 lines the half's mantissa up with the bottom bits of the float's
+		// and lets the FPU do the rounding.
+		const uint32_t denormMagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+		float denormMagic;
+		memcpy(&denormMagic, &denormMagicBits, sizeof(denormMagic));
+
+		float absValue;
+		memcpy(&absValue, &bits, sizeof(absValue));
+		absValue += denormMagic;
+
+		memcpy(&bits, &absValue, sizeof(bits));
+		half = (uint16_t)(bits - denormMagicBits);
+	}
+	else
+	{
+		// Rebias the exponent and round the mantissa to nearest even
+		uint32_t mantissaOdd = (bits >> 13) & 1;
+		bits += (uint32_t)(15 - 127) * (1u << 23) + 0xfff + mantissaOdd;
+		half = (uint16_t)(bits >> 13);
+	}
+
+	return (uint16_t)(half | sign);
+}
+
+float HalfToFloat(uint16_t value)
+{
+	const uint32_t shiftedExponent = 0x7c00 << 13;
+
+	uint32_t bits = (value & 0x7fff) << 13;
+	uint32_t exponent = bits & shiftedExponent;
+	bits += (127 - 15) << 23; // Rebias the exponent
+
+	if (exponent == shiftedExponent) // Inf/nan
+	{
+		bits += (128 - 16) << 23;
+	}
+	else if (exponent == 0) // Denormal, renormalize
+	{
+		const uint32_t magicBits = 113 << 23;
+		float magic;
+		memcpy(&magic, &magicBits, sizeof(magic));
+
+		bits += 1 << 23;
+
+		float result;
+		memcpy(&result, &bits, sizeof(result));
+		result -= magic;
+		memcpy(&bits, &result, sizeof(bits));
+	}
+
+	bits |= (uint32_t)(value & 0x8000) << 16;
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+#if CPU_X86
+CPU_TARGET("avx,f16c")
+static void FloatToHalfF16C(const float* source, uint16_t* destination, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm_storeu_si128((__m128i*)(destination + i), _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT));
+
+	for (; i < count; ++i)
+		destination[i] = FloatToHalf(source[i]);
+}
+
+CPU_TARGET("avx,f16c")
+static void HalfToFloatF16C(const uint16_t* source, float* destination, int count)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(destination + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(source + i))));
+
+	for (; i < count; ++i)
+		destination[i] = HalfToFloat(source[i]);
+}
+#endif
+
+static bool HasF16C()
+{
+	static const bool hasF16C = CpuFeatures::Get().AVX && CpuFeatures::Get().F16C;
+	return hasF16C;
+}
+
+void FloatToHalf(const float* source, uint16_t* destination, int count)
+{
+#if CPU_X86
+	if (HasF16C())
+	{
+		FloatToHalfF16C(source, destination, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; ++i)
+		destination[i] = FloatToHalf(source[i]);
+}
+
+void HalfToFloat(const uint16_t* source, float* destination, int count)
+{
+#if CPU_X86
+	if (HasF16C())
+	{
+		HalfToFloatF16C(source, destination, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; ++i)
+		destination[i] = HalfToFloat(source[i]);
+}
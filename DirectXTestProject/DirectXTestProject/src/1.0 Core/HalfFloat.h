@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// IEEE 754 half precision (fp16) conversions.
+// Rounds to nearest even like the F16C instructions, so the scalar and SIMD paths give the same bits.
+
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// Converts count values, using F16C when the CPU has it.
+void FloatToHalf(const float* source, uint16_t* destination, int count);
+void HalfToFloat(const uint16_t* source, float* destination, int count);
@@ -0,0 +1,210 @@
+#include "HeightField.h"
+#include "CpuFeatures.h"
+#include "HalfFloat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
+
+typedef void(*SampleHeightFieldFn)(const HeightFieldView&, const float*, const float*, int, float*, DirectX::XMFLOAT3*);
+
+// Everything both paths need per query, in the same order of operations so they give the same bits
+struct SampleParameters
+{
+	float InvCellSizeX;
+	float InvCellSizeZ;
+	float MaxU;		// Largest column coordinate
+	float MaxV;		// Largest row coordinate
+	int MaxCellColumn;
+	int MaxCellRow;
+};
+
+static SampleParameters GetSampleParameters(const HeightFieldView& field)
+{
+	SampleParameters parameters;
+	parameters.InvCellSizeX = 1.0f / field.CellSizeX;
+	parameters.InvCellSizeZ = 1.0f / field.CellSizeZ;
+	parameters.MaxU = (float)(field.NumColumns - 1);
+	parameters.MaxV = (float)(field.NumRows - 1);
+	parameters.MaxCellColumn = field.NumColumns - 2;
+	parameters.MaxCellRow = field.NumRows - 2;
+	return parameters;
+}
+
+static float LoadHeight(const HeightFieldView& field, int idx)
+{
+	if (field.Format == HeightFieldFormat::Float16)
+		return HalfToFloat(static_cast<const uint16_t*>(field.Heights)[idx]);
+
+	return static_cast<const float*>(field.Heights)[idx];
+}
+
+static void SampleHeightFieldScalar(const HeightFieldView& field, const float* x, const float* z, int count,
+	float* heights, DirectX::XMFLOAT3* normals)
+{
+	SampleParameters parameters = GetSampleParameters(field);
+
+	for (int i = 0; i < count; ++i)
+	{
+		// Grid coordinates, clamped to the grid. The comparisons are written like the SIMD min/max.
+		float u = (x[i] - field.OriginX) * parameters.InvCellSizeX;
+		float v = (field.OriginZ - z[i]) * parameters.InvCellSizeZ;
+		u = u > 0.0f ? u : 0.0f;
+		v = v > 0.0f ? v : 0.0f;
+		u = u < parameters.MaxU ? u : parameters.MaxU;
+		v = v < parameters.MaxV ? v : parameters.MaxV;
+
+		// The far edges use the last cell with a fraction of 1
+		int column = std::min<int>((int)u, parameters.MaxCellColumn);
+		int row = std::min<int>((int)v, parameters.MaxCellRow);
+		float fu = u - (float)column;
+		float fv = v - (float)row;
+
+		int idx = row * field.NumColumns + column;
+		float h00 = LoadHeight(field, idx);
+		float h01 = LoadHeight(field, idx + 1);
+		float h10 = LoadHeight(field, idx + field.NumColumns);
+		float h11 = LoadHeight(field, idx + field.NumColumns + 1);
+
+		float dTop = h01 - h00;
+		float dBottom = h11 - h10;
+		float top = h00 + dTop * fu;
+		float bottom = h10 + dBottom * fu;
+		float dv = bottom - top;
+
+		heights[i] = top + dv * fv;
+
+		if (!normals)
+			continue;
+
+		// Rows go down -z, so the z slope has the opposite sign of the row slope
+		float du = dTop + (dBottom - dTop) * fv;
+		float nx = -du * parameters.InvCellSizeX;
+		float nz = dv * parameters.InvCellSizeZ;
+		float invLength = 1.0f / std::sqrt(nx * nx + 1.0f + nz * nz);
+
+		normals[i] = DirectX::XMFLOAT3(nx * invLength, invLength, nz * invLength);
+	}
+}
+
+#if CPU_X86
+// Gathers the heights at idx and idx + 1 of 8 points
+CPU_TARGET("avx2,f16c")
+static void GatherHeightPairs(const HeightFieldView& field, __m256i idx, __m256& left, __m256& right)
+{
+	if (field.Format == HeightFieldFormat::Float16)
+	{
+		// 32 bits at a half hold it and its right neighbour, so one gather fetches both
+		__m256i pairs = _mm256_i32gather_epi32(static_cast<const int*>(field.Heights), idx, 2);
+		__m256i lefts = _mm256_and_si256(pairs, _mm256_set1_epi32(0xffff));
+		__m256i rights = _mm256_srli_epi32(pairs, 16);
+
+		// Pack to 16 bits (per 128-bit lane), then put the lanes in order: 8 lefts, 8 rights
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(lefts, rights), _MM_SHUFFLE(3, 1, 2, 0));
+		left = _mm256_cvtph_ps(_mm256_castsi256_si128(packed));
+		right = _mm256_cvtph_ps(_mm256_extracti128_si256(packed, 1));
+		return;
+	}
+
+	const float* heights = static_cast<const float*>(field.Heights);
+	left = _mm256_i32gather_ps(heights, idx, 4);
+	right = _mm256_i32gather_ps(heights + 1, idx, 4);
+}
+
+CPU_TARGET("avx2,f16c")
+static void SampleHeightFieldAVX2(const HeightFieldView& field, const float* x, const float* z, int count,
+	float* heights, DirectX::XMFLOAT3* normals)
+{
+	SampleParameters parameters = GetSampleParameters(field);
+
+	const __m256 originX = _mm256_set1_ps(field.OriginX);
+	const __m256 originZ = _mm256_set1_ps(field.OriginZ);
+	const __m256 invCellSizeX = _mm256_set1_ps(parameters.InvCellSizeX);
+	const __m256 invCellSizeZ = _mm256_set1_ps(parameters.InvCellSizeZ);
+	const __m256 maxU = _mm256_set1_ps(parameters.MaxU);
+	const __m256 maxV = _mm256_set1_ps(parameters.MaxV);
+	const __m256i maxCellColumn = _mm256_set1_epi32(parameters.MaxCellColumn);
+	const __m256i maxCellRow = _mm256_set1_epi32(parameters.MaxCellRow);
+	const __m256i numColumns = _mm256_set1_epi32(field.NumColumns);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 u = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), originX), invCellSizeX);
+		__m256 v = _mm256_mul_ps(_mm256_sub_ps(originZ, _mm256_loadu_ps(z + i)), invCellSizeZ);
+		u = _mm256_min_ps(_mm256_max_ps(u, zero), maxU);
+		v = _mm256_min_ps(_mm256_max_ps(v, zero), maxV);
+
+		__m256i column = _mm256_min_epi32(_mm256_cvttps_epi32(u), maxCellColumn);
+		__m256i row = _mm256_min_epi32(_mm256_cvttps_epi32(v), maxCellRow);
+		__m256 fu = _mm256_sub_ps(u, _mm256_cvtepi32_ps(column));
+		__m256 fv = _mm256_sub_ps(v, _mm256_cvtepi32_ps(row));
+
+		__m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(row, numColumns), column);
+
+		__m256 h00, h01, h10, h11;
+		GatherHeightPairs(field, idx, h00, h01);
+		GatherHeightPairs(field, _mm256_add_epi32(idx, numColumns), h10, h11);
+
+		__m256 dTop = _mm256_sub_ps(h01, h00);
+		__m256 dBottom = _mm256_sub_ps(h11, h10);
+		__m256 top = _mm256_add_ps(h00, _mm256_mul_ps(dTop, fu));
+		__m256 bottom = _mm256_add_ps(h10, _mm256_mul_ps(dBottom, fu));
+		__m256 dv = _mm256_sub_ps(bottom, top);
+
+		_mm256_storeu_ps(heights + i, _mm256_add_ps(top, _mm256_mul_ps(dv, fv)));
+
+		if (!normals)
+			continue;
+
+		__m256 du = _mm256_add_ps(dTop, _mm256_mul_ps(_mm256_sub_ps(dBottom, dTop), fv));
+		__m256 nx = _mm256_mul_ps(_mm256_xor_ps(du, signBit), invCellSizeX);
+		__m256 nz = _mm256_mul_ps(dv, invCellSizeZ);
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), one), _mm256_mul_ps(nz, nz));
+		__m256 invLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSq));
+
+		alignas(32) float normalX[8];
+		alignas(32) float normalY[8];
+		alignas(32) float normalZ[8];
+		_mm256_store_ps(normalX, _mm256_mul_ps(nx, invLength));
+		_mm256_store_ps(normalY, invLength);
+		_mm256_store_ps(normalZ, _mm256_mul_ps(nz, invLength));
+
+		for (int j = 0; j < 8; ++j)
+			normals[i + j] = DirectX::XMFLOAT3(normalX[j], normalY[j], normalZ[j]);
+	}
+
+	SampleHeightFieldScalar(field, x + i, z + i, count - i, heights + i, normals ? normals + i : nullptr);
+}
+#endif
+
+static SampleHeightFieldFn GetSampleHeightFieldFn()
+{
+#if CPU_X86
+	const CpuFeatures& features = CpuFeatures::Get();
+	if (features.AVX2 && features.F16C)
+		return &SampleHeightFieldAVX2;
+#endif
+
+	return &SampleHeightFieldScalar;
+}
+
+static const SampleHeightFieldFn s_SampleHeightField = GetSampleHeightFieldFn();
+
+void SampleHeightField(const HeightFieldView& field, const float* x, const float* z, int count,
+	float* heights, DirectX::XMFLOAT3* normals)
+{
+	assert(field.Heights && field.NumRows >= 2 && field.NumColumns >= 2);
+	assert(count >= 0);
+
+	s_SampleHeightField(field, x, z, count, heights, normals);
+}
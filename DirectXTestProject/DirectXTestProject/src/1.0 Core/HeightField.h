@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <DirectXMath.h>
+
+enum class HeightFieldFormat : char
+{
+	Float32 = 0,
+	Float16
+};
+
+// Non-owning view of a regular grid of heights over the xz-plane, like the grids of
+// GeometryGenerator::CreateGrid and the wave solvers: row major, row 0 at the +z edge and column 0 at the -x edge.
+// Grid point (row, column) is at (OriginX + column * CellSizeX, OriginZ - row * CellSizeZ).
+struct HeightFieldView
+{
+	const void* Heights = nullptr;		// NumRows * NumColumns heights of the given format
+	HeightFieldFormat Format = HeightFieldFormat::Float32;
+	int NumRows = 0;
+	int NumColumns = 0;
+	float OriginX = 0.0f;
+	float OriginZ = 0.0f;
+	float CellSizeX = 1.0f;
+	float CellSizeZ = 1.0f;
+};
+
+// Samples the height field at count points (x[i], z[i]) in world space: heights[i] is interpolated bilinearly
+// and normals[i] (if not nullptr) is the normal of that bilinear surface. Points outside the grid are clamped to its edge.
+// Runs 8 points per iteration with AVX2 when the CPU has it, which gives the same results as the scalar path.
+void SampleHeightField(const HeightFieldView& field, const float* x, const float* z, int count,
+	float* heights, DirectX::XMFLOAT3* normals);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+// A plane of heights (one per grid point, row major) of the wave solver. It either owns its heights
+// or uses memory someone else keeps alive, like a mapped snapshot file, so restoring a snapshot doesn't copy anything.
+// Moving a plane (std::swap) moves the heights along, planes can't be copied.
+template<typename T>
+class HeightPlane
+{
+public:
+	HeightPlane() = default;
+	HeightPlane(const HeightPlane& other) = delete;
+	HeightPlane& operator=(const HeightPlane& other) = delete;
+	HeightPlane(HeightPlane&& other) = default;
+	HeightPlane& operator=(HeightPlane&& other) = default;
+
+	T* GetData() { return m_Data; }
+	const T* GetData() const { return m_Data; }
+	int GetSize() const { return m_Size; }
+	bool IsEmpty() const { return m_Size == 0; }
+
+	T& operator[](int idx) { return m_Data[idx]; }
+	const T& operator[](int idx) const { return m_Data[idx]; }
+
+	// Owns count heights, all set to value
+	void Assign(int count, T value)
+	{
+		m_Owner.reset();
+		m_Heights.assign(count, value);
+		m_Data = m_Heights.data();
+		m_Size = count;
+	}
+
+	// Owns count heights. Heights it used already are kept, new ones are 0.
+	void Resize(int count)
+	{
+		if (m_Owner)
+		{
+			m_Heights.assign(m_Data, m_Data + std::min<int>(m_Size, count));
+			m_Owner.reset();
+		}
+
+		m_Heights.resize(count, T());
+		m_Data = m_Heights.data();
+		m_Size = count;
+	}
+
+	// Uses count heights in memory that stays valid as long as owner lives
+	void Attach(T* heights, int count, std::shared_ptr<void> owner)
+	{
+		assert(heights && owner);
+
+		std::vector<T>().swap(m_Heights);
+		m_Owner = std::move(owner);
+		m_Data = heights;
+		m_Size = count;
+	}
+
+	// Owns a copy of the heights it uses, so the memory it was attached to can go away
+	void Detach()
+	{
+		if (m_Owner)
+			this->Resize(m_Size);
+	}
+
+	// Lets go of the heights (and their memory)
+	void Release()
+	{
+		std::vector<T>().swap(m_Heights);
+		m_Owner.reset();
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+private:
+	std::vector<T> m_Heights;
+	std::shared_ptr<void> m_Owner;
+	T* m_Data = nullptr;
+	int m_Size = 0;
+};
@@ -0,0 +1,175 @@
+#include "IndexData.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <utility>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+static const uint32_t s_MaxIndex16 = 0xFFFF;
+
+typedef uint32_t(*FindMaxIndexFn)(const uint32_t*, size_t);
+typedef void(*NarrowIndicesFn)(const uint32_t*, size_t, uint16_t*);
+
+static uint32_t FindMaxIndexScalar(const uint32_t* indices, size_t count)
+{
+	uint32_t maxIndex = 0;
+	for (size_t i = 0; i < count; ++i)
+		maxIndex = std::max<uint32_t>(maxIndex, indices[i]);
+
+	return maxIndex;
+}
+
+// Every index is read before the 16 bit ones written so far reach it, which is what lets the narrowing run in place
+static void NarrowIndicesScalar(const uint32_t* indices, size_t count, uint16_t* destination)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		assert(indices[i] <= s_MaxIndex16);
+		destination[i] = (uint16_t)indices[i];
+	}
+}
+
+#if CPU_X86
+CPU_TARGET("avx2")
+static uint32_t FindMaxIndexAVX2(const uint32_t* indices, size_t count)
+{
+	__m256i maxIndices = _mm256_setzero_si256();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+		maxIndices = _mm256_max_epu32(maxIndices, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i)));
+
+	__m128i maxIndex = _mm_max_epu32(_mm256_castsi256_si128(maxIndices), _mm256_extracti128_si256(maxIndices, 1));
+	maxIndex = _mm_max_epu32(maxIndex, _mm_shuffle_epi32(maxIndex, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxIndex = _mm_max_epu32(maxIndex, _mm_shuffle_epi32(maxIndex, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	uint32_t result = (uint32_t)_mm_cvtsi128_si32(maxIndex);
+
+	// Calling into the scalar code without a tail costs an AVX/SSE state transition per call
+	if (i < count)
+		result = std::max<uint32_t>(result, FindMaxIndexScalar(indices + i, count - i));
+
+	return result;
+}
+
+// A block of 16 indices is loaded before its 32 bytes of 16 bit indices are stored, and the store
+// ends where the block starts for every block but the first, so the narrowing can run in place
+CPU_TARGET("avx2")
+static void NarrowIndicesAVX2(const uint32_t* indices, size_t count, uint16_t* destination)
+{
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+		__m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i + 8));
+
+		// Packing works within 128 bit lanes: 0-3 8-11 | 4-7 12-15, the permute puts them back in order
+		__m256i narrowed = _mm256_packus_epi32(low, high);
+		narrowed = _mm256_permute4x64_epi64(narrowed, _MM_SHUFFLE(3, 1, 2, 0));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), narrowed);
+	}
+
+	if (i < count)
+		NarrowIndicesScalar(indices + i, count - i, destination + i);
+}
+#endif
+
+static FindMaxIndexFn GetFindMaxIndexFn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX2)
+		return &FindMaxIndexAVX2;
+#endif
+
+	return &FindMaxIndexScalar;
+}
+
+static NarrowIndicesFn GetNarrowIndicesFn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX2)
+		return &NarrowIndicesAVX2;
+#endif
+
+	return &NarrowIndicesScalar;
+}
+
+static const FindMaxIndexFn s_FindMaxIndex = GetFindMaxIndexFn();
+static const NarrowIndicesFn s_NarrowIndices = GetNarrowIndicesFn();
+
+uint32_t FindMaxIndex(const uint32_t* indices, size_t count)
+{
+	return s_FindMaxIndex(indices, count);
+}
+
+void NarrowIndices(const uint32_t* indices, size_t count, uint16_t* destination)
+{
+	s_NarrowIndices(indices, count, destination);
+}
+
+IndexData::IndexData(std::vector<uint32_t>&& indices)
+	: m_Storage(std::move(indices))
+	, m_Count(m_Storage.size())
+{
+	if (FindMaxIndex(m_Storage.data(), m_Count) > s_MaxIndex16)
+		return;
+
+	uint16_t* indices16 = reinterpret_cast<uint16_t*>(m_Storage.data());
+	NarrowIndices(m_Storage.data(), m_Count, indices16);
+
+	// An odd count leaves half an element, cleared so the buffer only depends on the indices
+	if (m_Count % 2 != 0)
+		indices16[m_Count] = 0;
+
+	m_Storage.resize((m_Count + 1) / 2);
+	m_Storage.shrink_to_fit();
+	m_Is16Bit = true;
+}
+
+IndexData::IndexData(const uint32_t* indices, size_t count)
+	: m_Count(count)
+{
+	if (FindMaxIndex(indices, count) > s_MaxIndex16)
+	{
+		m_Storage.assign(indices, indices + count);
+		return;
+	}
+
+	m_Storage.resize((count + 1) / 2);
+	NarrowIndices(indices, count, reinterpret_cast<uint16_t*>(m_Storage.data()));
+	m_Is16Bit = true;
+}
+
+Span<uint16_t> IndexData::GetIndices16() const
+{
+	assert(m_Is16Bit);
+
+	Span<uint16_t> indices;
+	indices.Data = reinterpret_cast<const uint16_t*>(m_Storage.data());
+	indices.Count = m_Count;
+	return indices;
+}
+
+Span<uint32_t> IndexData::GetIndices32() const
+{
+	assert(!m_Is16Bit);
+
+	Span<uint32_t> indices;
+	indices.Data = m_Storage.data();
+	indices.Count = m_Count;
+	return indices;
+}
+
+uint32_t IndexData::GetIndex(size_t i) const
+{
+	assert(i < m_Count);
+
+	if (m_Is16Bit)
+		return reinterpret_cast<const uint16_t*>(m_Storage.data())[i];
+
+	return m_Storage[i];
+}
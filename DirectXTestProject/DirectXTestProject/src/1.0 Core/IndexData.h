@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <dxgiformat.h>
+
+// A view of count elements of type T, what this code needs of C++20's std::span
+template<typename T>
+struct Span
+{
+	const T* Data = nullptr;
+	size_t Count = 0;
+
+	const T* begin() const { return Data; }
+	const T* end() const { return Data + Count; }
+	bool empty() const { return Count == 0; }
+
+	const T& operator[](size_t i) const
+	{
+		assert(i < Count);
+		return Data[i];
+	}
+};
+
+// Indices in the narrowest format that holds them: 16 bits when they are all below 65536, 32 bits otherwise.
+// There is a single copy of them, 32 bit indices that fit in 16 bits are narrowed in place (with AVX2 when
+// the CPU has it) and their memory shrinks to half. Meshes drawn with BaseVertexLocation only need their
+// own indices to fit, so several meshes can share a 16 bit index buffer even with more vertices in total.
+class IndexData
+{
+public:
+	IndexData() = default;
+
+	// Takes the indices over, they are narrowed in their own memory
+	explicit IndexData(std::vector<uint32_t>&& indices);
+
+	// Copies the indices, straight into 16 bits when they fit
+	IndexData(const uint32_t* indices, size_t count);
+
+	DXGI_FORMAT GetFormat() const { return m_Is16Bit ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT; }
+	bool Is16Bit() const { return m_Is16Bit; }
+
+	size_t GetCount() const { return m_Count; }
+	size_t GetByteSize() const { return m_Count * (m_Is16Bit ? sizeof(uint16_t) : sizeof(uint32_t)); }
+
+	// The indices in the format of GetFormat, for index buffers
+	const void* GetData() const { return m_Storage.data(); }
+
+	// Only the one of the format the indices are in can be called
+	Span<uint16_t> GetIndices16() const;
+	Span<uint32_t> GetIndices32() const;
+
+	uint32_t GetIndex(size_t i) const;
+
+private:
+	// 32 bit indices, or 16 bit ones packed two to an element
+	std::vector<uint32_t> m_Storage;
+	size_t m_Count = 0;
+	bool m_Is16Bit = false;
+};
+
+// The largest index, 0 for no indices
+uint32_t FindMaxIndex(const uint32_t* indices, size_t count);
+
+// Truncates the indices to 16 bits, they must all fit. destination can be the memory of the indices.
+void NarrowIndices(const uint32_t* indices, size_t count, uint16_t* destination);
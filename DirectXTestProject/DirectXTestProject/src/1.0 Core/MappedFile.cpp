@@ -0,0 +1,196 @@
+#include "MappedFile.h"
+
+#include <cassert>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(uint8_t* data, size_t size):
+	m_Data(data),
+	m_Size(size)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	this->Unmap();
+
+	if (m_TempFileName.empty())
+		return;
+
+#if defined(_WIN32)
+	DeleteFileW(m_TempFileName.c_str());
+#else
+	std::string narrowTempFileName(m_TempFileName.begin(), m_TempFileName.end());
+	unlink(narrowTempFileName.c_str());
+#endif
+}
+
+void MappedFile::Unmap()
+{
+	if (!m_Data)
+		return;
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_Data);
+#else
+	munmap(m_Data, m_Size);
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::wstring& fileName)
+{
+#if defined(_WIN32)
+	HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	// The view keeps the mapping (and the file) open, the handles aren't needed after mapping it
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return nullptr;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data)
+		return nullptr;
+
+	return std::shared_ptr<MappedFile>(new MappedFile(static_cast<uint8_t*>(data), (size_t)fileSize.QuadPart));
+#else
+	std::string narrowFileName(fileName.begin(), fileName.end());
+
+	int file = open(narrowFileName.c_str(), O_RDONLY);
+	if (file < 0)
+		return nullptr;
+
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close(file);
+		return nullptr;
+	}
+
+	void* data = mmap(nullptr, (size_t)fileStatus.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return nullptr;
+
+	return std::shared_ptr<MappedFile>(new MappedFile(static_cast<uint8_t*>(data), (size_t)fileStatus.st_size));
+#endif
+}
+
+std::shared_ptr<MappedFile> MappedFile::Create(const std::wstring& fileName, size_t size)
+{
+	if (size == 0)
+		return nullptr;
+
+	std::wstring tempFileName = fileName + L".tmp";
+	std::shared_ptr<MappedFile> mappedFile;
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileW(tempFileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	// Mapping more than the file holds grows the file to the size of the mapping
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+	{
+		DeleteFileW(tempFileName.c_str());
+		return nullptr;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data)
+	{
+		DeleteFileW(tempFileName.c_str());
+		return nullptr;
+	}
+
+	mappedFile.reset(new MappedFile(static_cast<uint8_t*>(data), size));
+#else
+	std::string narrowTempFileName(tempFileName.begin(), tempFileName.end());
+
+	int file = open(narrowTempFileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (file < 0)
+		return nullptr;
+
+	if (ftruncate(file, (off_t)size) != 0)
+	{
+		close(file);
+		unlink(narrowTempFileName.c_str());
+		return nullptr;
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		unlink(narrowTempFileName.c_str());
+		return nullptr;
+	}
+
+	mappedFile.reset(new MappedFile(static_cast<uint8_t*>(data), size));
+#endif
+
+	mappedFile->m_FileName = fileName;
+	mappedFile->m_TempFileName = tempFileName;
+
+	return mappedFile;
+}
+
+bool MappedFile::Commit()
+{
+	assert(!m_TempFileName.empty() && "Only files made with Create can be committed, and only once");
+
+	// The data has to be on disk before the rename makes it the file, or a crash could leave a renamed file of zeros
+#if defined(_WIN32)
+	bool flushed = FlushViewOfFile(m_Data, 0) != 0;
+	this->Unmap();
+
+	bool committed = flushed && MoveFileExW(m_TempFileName.c_str(), m_FileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	bool flushed = msync(m_Data, m_Size, MS_SYNC) == 0;
+	this->Unmap();
+
+	std::string narrowTempFileName(m_TempFileName.begin(), m_TempFileName.end());
+	std::string narrowFileName(m_FileName.begin(), m_FileName.end());
+	bool committed = flushed && rename(narrowTempFileName.c_str(), narrowFileName.c_str()) == 0;
+#endif
+
+	// A temporary file that didn't make it is deleted by the destructor
+	if (committed)
+		m_TempFileName.clear();
+
+	return committed;
+}
+
+uint8_t* MappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// A whole file mapped into memory. Pages are only read from disk when they are touched,
+// so mapping a big file costs next to nothing until its data is used.
+class MappedFile
+{
+public:
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	~MappedFile();
+
+	// Maps an existing file copy-on-write: the memory can be written to, but the writes stay private to this process
+	// and never reach the file (a page is copied the first time it is written to).
+	// Returns nullptr if the file can't be opened or is empty.
+	static std::shared_ptr<MappedFile> Open(const std::wstring& fileName);
+
+	// Creates a file of size bytes and maps it, what is written to the memory ends up in the file.
+	// The file is written as fileName.tmp and only replaces fileName on Commit, so a write that is cut short
+	// never leaves a partial file under the final name. Without Commit the temporary file is deleted again.
+	// Returns nullptr if the file can't be created.
+	static std::shared_ptr<MappedFile> Create(const std::wstring& fileName, size_t size);
+
+	// Flushes and unmaps a file made with Create and moves it in place of the file it was created for.
+	// Returns false if it can't be replaced (on Windows, a file that is still mapped can't be).
+	bool Commit();
+
+	uint8_t* GetData() const;
+	size_t GetSize() const;
+
+private:
+	MappedFile(uint8_t* data, size_t size);
+	void Unmap();
+
+private:
+	uint8_t* m_Data;
+	size_t m_Size;
+
+	// Only set for files made with Create that aren't committed yet
+	std::wstring m_FileName;
+	std::wstring m_TempFileName;
+};
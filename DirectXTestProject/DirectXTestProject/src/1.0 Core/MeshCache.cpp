@@ -0,0 +1,313 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Part of every key: bump it when GeometryGenerator (or the optimisation of its meshes) changes the meshes it makes,
+// so the files of the old meshes aren't found anymore.
+static const uint32_t s_GeneratorVersion = 3;
+
+enum class MeshKind : uint32_t
+{
+	Box = 0,
+	Grid,
+	Cylinder,
+	Sphere,
+	GeoSphere
+};
+
+// A mesh file is the header, the key (to tell hash collisions apart), the vertices and the indices.
+// The hash of everything after the header catches files that are damaged or weren't written completely.
+struct MeshFileHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t KeySize;
+	uint32_t VertexSize;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint64_t PayloadHash;
+};
+
+static_assert(sizeof(MeshFileHeader) == 32, "The mesh file header has no padding");
+
+static const char s_MeshFileMagic[4] = { 'M', 'E', 'S', 'H' };
+static const uint32_t s_MeshFileVersion = 2;
+
+static uint32_t GetFloatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+// 64 bit FNV-1a over size bytes
+static uint64_t HashBytes(const uint8_t* data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Names the file of a mesh, the key words are hashed in memory order (little endian on every platform we build for)
+static uint64_t HashKey(const std::vector<uint32_t>& key)
+{
+	return HashBytes(reinterpret_cast<const uint8_t*>(key.data()), key.size() * sizeof(uint32_t));
+}
+
+static void CreateDirectoryIfMissing(const std::wstring& directory)
+{
+#if defined(_WIN32)
+	CreateDirectoryW(directory.c_str(), nullptr);
+#else
+	std::string narrowDirectory(directory.begin(), directory.end());
+	mkdir(narrowDirectory.c_str(), 0755);
+#endif
+}
+
+MeshCache::MeshCache(const std::wstring& directory):
+	m_Directory(directory)
+{
+	if (!m_Directory.empty())
+		CreateDirectoryIfMissing(m_Directory);
+}
+
+MeshCache::~MeshCache()
+{
+
+}
+
+MeshCache& MeshCache::Get()
+{
+	static MeshCache cache(L"../data/meshcache");
+	return cache;
+}
+
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::CreateBox(float width, float height, float depth, uint32_t numSubdivisions)
+{
+	MeshKey key = { s_GeneratorVersion, (uint32_t)MeshKind::Box, GetFloatBits(width), GetFloatBits(height), GetFloatBits(depth), numSubdivisions };
+
+	return this->Find(key, true, [=]()
+	{
+		GeometryGenerator geoGen;
+		return geoGen.CreateBox(width, height, depth, numSubdivisions);
+	});
+}
+
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::CreateGrid(float width, float depth, uint32_t m, uint32_t n)
+{
+	MeshKey key = { s_GeneratorVersion, (uint32_t)MeshKind::Grid, GetFloatBits(width), GetFloatBits(depth), m, n };
+
+	// Height fields are built from the vertices of grids, which have to stay row major
+	return this->Find(key, false, [=]()
+	{
+		GeometryGenerator geoGen;
+		return geoGen.CreateGrid(width, depth, m, n);
+	});
+}
+
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount)
+{
+	MeshKey key = { s_GeneratorVersion, (uint32_t)MeshKind::Cylinder, GetFloatBits(bottomRadius), GetFloatBits(topRadius), GetFloatBits(height), sliceCount, stackCount };
+
+	return this->Find(key, true, [=]()
+	{
+		GeometryGenerator geoGen;
+		return geoGen.CreateCylinder(bottomRadius, topRadius, height, sliceCount, stackCount);
+	});
+}
+
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount)
+{
+	MeshKey key = { s_GeneratorVersion, (uint32_t)MeshKind::Sphere, GetFloatBits(radius), sliceCount, stackCount };
+
+	return this->Find(key, true, [=]()
+	{
+		GeometryGenerator geoGen;
+		return geoGen.CreateSphere(radius, sliceCount, stackCount);
+	});
+}
+
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::CreateGeoSphere(float radius, uint32_t numSubdivisions)
+{
+	MeshKey key = { s_GeneratorVersion, (uint32_t)MeshKind::GeoSphere, GetFloatBits(radius), numSubdivisions };
+
+	return this->Find(key, true, [=]()
+	{
+		GeometryGenerator geoGen;
+		return geoGen.CreateGeoSphere(radius, numSubdivisions);
+	});
+}
+
+void MeshCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Meshes.clear();
+}
+
+int MeshCache::GetMemoryHitCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_MemoryHitCount;
+}
+
+int MeshCache::GetDiskHitCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_DiskHitCount;
+}
+
+int MeshCache::GetMissCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_MissCount;
+}
+
+template<typename TGenerate>
+std::shared_ptr<const GeometryGenerator::MeshData> MeshCache::Find(const MeshKey& key, bool reorderVertices, const TGenerate& generate)
+{
+	uint64_t hash = HashKey(key);
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto range = m_Meshes.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second.Key == key)
+			{
+				++m_MemoryHitCount;
+				return it->second.Mesh;
+			}
+		}
+	}
+
+	// Loading and generating happen outside the lock, so other threads can look up meshes meanwhile.
+	// Threads asking for the same new mesh at once all make it, the first one to finish is kept.
+	std::shared_ptr<GeometryGenerator::MeshData> mesh = this->Load(key, hash);
+	bool loaded = mesh != nullptr;
+
+	if (!loaded)
+	{
+		mesh = std::make_shared<GeometryGenerator::MeshData>(generate());
+		OptimizeMesh(*mesh, reorderVertices);
+
+		this->Save(key, hash, *mesh);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (loaded)
+		++m_DiskHitCount;
+	else
+		++m_MissCount;
+
+	auto range = m_Meshes.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second.Key == key)
+			return it->second.Mesh;
+	}
+
+	m_Meshes.emplace(hash, Entry{ key, mesh });
+	return mesh;
+}
+
+std::shared_ptr<GeometryGenerator::MeshData> MeshCache::Load(const MeshKey& key, uint64_t hash) const
+{
+	if (m_Directory.empty())
+		return nullptr;
+
+	std::shared_ptr<MappedFile> file = MappedFile::Open(this->GetFileName(hash));
+	if (!file || file->GetSize() < sizeof(MeshFileHeader))
+		return nullptr;
+
+	const uint8_t* data = file->GetData();
+	const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(data);
+
+	// Files of another version, of another key with the same hash, truncated and damaged ones are generated again
+	uint64_t keySize = key.size() * sizeof(uint32_t);
+	uint64_t verticesOffset = sizeof(MeshFileHeader) + keySize;
+	uint64_t indicesOffset = verticesOffset + (uint64_t)header.VertexCount * sizeof(GeometryGenerator::Vertex);
+	uint64_t fileSize = indicesOffset + (uint64_t)header.IndexCount * sizeof(uint32_t);
+
+	if (memcmp(header.Magic, s_MeshFileMagic, sizeof(header.Magic)) != 0 ||
+		header.Version != s_MeshFileVersion ||
+		header.VertexSize != sizeof(GeometryGenerator::Vertex) ||
+		header.KeySize != key.size() ||
+		fileSize != file->GetSize() ||
+		memcmp(data + sizeof(MeshFileHeader), key.data(), (size_t)keySize) != 0 ||
+		HashBytes(data + sizeof(MeshFileHeader), (size_t)(fileSize - sizeof(MeshFileHeader))) != header.PayloadHash)
+		return nullptr;
+
+	std::shared_ptr<GeometryGenerator::MeshData> meshData = std::make_shared<GeometryGenerator::MeshData>();
+
+	const GeometryGenerator::Vertex* vertices = reinterpret_cast<const GeometryGenerator::Vertex*>(data + verticesOffset);
+	meshData->Vertices.assign(vertices, vertices + header.VertexCount);
+
+	const uint32_t* indices = reinterpret_cast<const uint32_t*>(data + indicesOffset);
+	meshData->Indices32.assign(indices, indices + header.IndexCount);
+
+	return meshData;
+}
+
+void MeshCache::Save(const MeshKey& key, uint64_t hash, const GeometryGenerator::MeshData& meshData) const
+{
+	if (m_Directory.empty())
+		return;
+
+	MeshFileHeader header = {};
+	memcpy(header.Magic, s_MeshFileMagic, sizeof(header.Magic));
+	header.Version = s_MeshFileVersion;
+	header.KeySize = (uint32_t)key.size();
+	header.VertexSize = sizeof(GeometryGenerator::Vertex);
+	header.VertexCount = (uint32_t)meshData.Vertices.size();
+	header.IndexCount = (uint32_t)meshData.Indices32.size();
+
+	size_t keySize = key.size() * sizeof(uint32_t);
+	size_t verticesSize = meshData.Vertices.size() * sizeof(GeometryGenerator::Vertex);
+	size_t indicesSize = meshData.Indices32.size() * sizeof(uint32_t);
+
+	// A cache that can't be written to only costs the time of generating the mesh again next run.
+	// The file only gets its final name once it is complete, so Load never finds one that is still being written.
+	std::shared_ptr<MappedFile> file = MappedFile::Create(this->GetFileName(hash), sizeof(MeshFileHeader) + keySize + verticesSize + indicesSize);
+	if (!file)
+		return;
+
+	uint8_t* payload = file->GetData() + sizeof(MeshFileHeader);
+	uint8_t* data = payload;
+	memcpy(data, key.data(), keySize);
+	data += keySize;
+	memcpy(data, meshData.Vertices.data(), verticesSize);
+	data += verticesSize;
+	memcpy(data, meshData.Indices32.data(), indicesSize);
+
+	header.PayloadHash = HashBytes(payload, keySize + verticesSize + indicesSize);
+	memcpy(file->GetData(), &header, sizeof(MeshFileHeader));
+
+	file->Commit();
+}
+
+std::wstring MeshCache::GetFileName(uint64_t hash) const
+{
+	static const wchar_t s_HexDigits[] = L"0123456789abcdef";
+
+	std::wstring fileName = m_Directory + L"/";
+	for (int digit = 15; digit >= 0; --digit)
+		fileName += s_HexDigits[(hash >> (4 * digit)) & 0xF];
+
+	return fileName + L".mesh";
+}
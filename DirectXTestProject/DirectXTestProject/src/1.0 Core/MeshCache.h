@@ -0,0 +1,75 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Caches the meshes of GeometryGenerator, keyed by a hash of the generator call and its parameters.
+// A mesh is generated once: later calls with the same parameters share it from memory and later runs
+// load it from a binary file in the cache directory instead of generating it again.
+// Generated meshes are optimised for the vertex cache and fetch (see OptimizeMesh) before they are cached,
+// grids keep their row major vertices. The meshes are immutable once cached: callers read them where they are
+// (an IndexData can be made from the indices of one) and copy the ones they need to change.
+// All methods can be called from any thread.
+class MeshCache
+{
+public:
+	// Files go to directory (created when missing), an empty directory keeps the cache in memory only
+	explicit MeshCache(const std::wstring& directory);
+	MeshCache(const MeshCache& other) = delete;
+	MeshCache& operator=(const MeshCache& other) = delete;
+	~MeshCache();
+
+	// The cache the apps share, its files are in ../data/meshcache/
+	static MeshCache& Get();
+
+	// Same parameters as the GeometryGenerator methods of the same name. The mesh is generated on the first call,
+	// shared from memory on later calls and loaded from its file on later runs; callers read it where the cache keeps it.
+	// When several meshes are appended into one buffer, an IndexData of their indices stays 16 bit
+	// as long as every mesh has at most 64K vertices and is drawn from its BaseVertexLocation.
+	std::shared_ptr<const GeometryGenerator::MeshData> CreateBox(float width, float height, float depth, uint32_t numSubdivisions);
+	std::shared_ptr<const GeometryGenerator::MeshData> CreateGrid(float width, float depth, uint32_t m, uint32_t n);
+	std::shared_ptr<const GeometryGenerator::MeshData> CreateCylinder(float bottomRadius, float topRadius, float height, uint32_t sliceCount, uint32_t stackCount);
+	std::shared_ptr<const GeometryGenerator::MeshData> CreateSphere(float radius, uint32_t sliceCount, uint32_t stackCount);
+	std::shared_ptr<const GeometryGenerator::MeshData> CreateGeoSphere(float radius, uint32_t numSubdivisions);
+
+	// Drops the meshes held in memory, the files stay
+	void Clear();
+
+	// Lookups served from memory, from the files and by generating the mesh
+	int GetMemoryHitCount() const;
+	int GetDiskHitCount() const;
+	int GetMissCount() const;
+
+private:
+	// The generator call and its parameters, as 32 bit words: the mesh kind, then the parameters in order
+	typedef std::vector<uint32_t> MeshKey;
+
+	template<typename TGenerate>
+	std::shared_ptr<const GeometryGenerator::MeshData> Find(const MeshKey& key, bool reorderVertices, const TGenerate& generate);
+
+	std::shared_ptr<GeometryGenerator::MeshData> Load(const MeshKey& key, uint64_t hash) const;
+	void Save(const MeshKey& key, uint64_t hash, const GeometryGenerator::MeshData& meshData) const;
+	std::wstring GetFileName(uint64_t hash) const;
+
+private:
+	struct Entry
+	{
+		MeshKey Key;
+		std::shared_ptr<const GeometryGenerator::MeshData> Mesh;
+	};
+
+	std::wstring m_Directory;
+
+	mutable std::mutex m_Mutex;
+	std::unordered_multimap<uint64_t, Entry> m_Meshes;
+
+	int m_MemoryHitCount = 0;
+	int m_DiskHitCount = 0;
+	int m_MissCount = 0;
+};
@@ -0,0 +1,188 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, int cacheSize)
+{
+	VertexCacheStats stats;
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	// A vertex is in the FIFO until cacheSize other vertices missed after it
+	std::vector<uint32_t> missTimes(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	uint32_t missCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t vertex = indices[i];
+		assert(vertex < vertexCount);
+
+		if (time - missTimes[vertex] > (uint32_t)cacheSize)
+		{
+			missTimes[vertex] = time++;
+			++missCount;
+		}
+	}
+
+	stats.Acmr = (float)missCount / (float)(indexCount / 3);
+	stats.Atvr = (float)missCount / (float)vertexCount;
+
+	return stats;
+}
+
+// The next vertex to fan around once the candidates of a fan have no triangles left:
+// the most recently used vertex that still has some, else the first vertex (from cursor on) that has some
+static uint32_t SkipDeadEnd(std::vector<uint32_t>& deadEnds, const std::vector<uint32_t>& liveCounts, uint32_t& cursor)
+{
+	while (!deadEnds.empty())
+	{
+		uint32_t vertex = deadEnds.back();
+		deadEnds.pop_back();
+
+		if (liveCounts[vertex] > 0)
+			return vertex;
+	}
+
+	for (; cursor < (uint32_t)liveCounts.size(); ++cursor)
+	{
+		if (liveCounts[cursor] > 0)
+			return cursor;
+	}
+
+	return ~0u;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, int cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	// The triangles around every vertex, those of vertex v are [adjacencyOffsets[v], adjacencyOffsets[v + 1])
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++adjacencyOffsets[indices[i] + 1];
+
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> adjacencyEnds(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		adjacency[adjacencyEnds[indices[i]]++] = (uint32_t)(i / 3);
+
+	// Triangles around every vertex that weren't emitted yet
+	std::vector<uint32_t> liveCounts(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		liveCounts[vertex] = adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex];
+
+	std::vector<uint32_t> cacheTimes(vertexCount, 0);
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> output(triangleCount * 3);
+	deadEnds.reserve(triangleCount * 3);
+
+	uint32_t time = cacheSize + 1;
+	uint32_t cursor = 0;
+	size_t outputCount = 0;
+
+	uint32_t fanVertex = 0;
+	while (fanVertex != ~0u)
+	{
+		// Emit every triangle around the vertex that is left
+		candidates.clear();
+
+		for (uint32_t k = adjacencyOffsets[fanVertex]; k < adjacencyOffsets[fanVertex + 1]; ++k)
+		{
+			uint32_t triangle = adjacency[k];
+			if (emitted[triangle])
+				continue;
+
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+				output[outputCount++] = vertex;
+
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveCounts[vertex];
+
+				if (time - cacheTimes[vertex] > (uint32_t)cacheSize)
+					cacheTimes[vertex] = time++;
+			}
+
+			emitted[triangle] = 1;
+		}
+
+		// Fan around the candidate that stays in the cache while its triangles are emitted
+		// and has been in it the longest (it is the first to be evicted), else around any candidate with triangles left
+		uint32_t nextVertex = ~0u;
+		int bestPriority = -1;
+
+		for (uint32_t vertex : candidates)
+		{
+			if (liveCounts[vertex] == 0)
+				continue;
+
+			int priority = 0;
+			if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= (uint32_t)cacheSize)
+				priority = (int)(time - cacheTimes[vertex]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = vertex;
+			}
+		}
+
+		if (nextVertex == ~0u)
+			nextVertex = SkipDeadEnd(deadEnds, liveCounts, cursor);
+
+		fanVertex = nextVertex;
+	}
+
+	assert(outputCount == triangleCount * 3);
+
+	// Meshes that come ordered well already (like scanned or authored ones) can be a bit better off as they are
+	VertexCacheStats inputStats = AnalyzeVertexCache(indices, triangleCount * 3, vertexCount, cacheSize);
+	VertexCacheStats outputStats = AnalyzeVertexCache(output.data(), triangleCount * 3, vertexCount, cacheSize);
+
+	if (outputStats.Acmr < inputStats.Acmr)
+		std::copy(output.begin(), output.end(), indices);
+}
+
+uint32_t BuildVertexFetchRemap(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap)
+{
+	remap.assign(vertexCount, ~0u);
+	uint32_t usedVertexCount = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& vertex = remap[indices[i]];
+		if (vertex == ~0u)
+			vertex = usedVertexCount++;
+
+		indices[i] = vertex;
+	}
+
+	return usedVertexCount;
+}
+
+MeshOptimizationStats OptimizeMesh(GeometryGenerator::MeshData& meshData, bool reorderVertices, int cacheSize)
+{
+	std::vector<uint32_t>& indices = meshData.Indices32;
+
+	MeshOptimizationStats stats;
+	stats.Before = AnalyzeVertexCache(indices.data(), indices.size(), (uint32_t)meshData.Vertices.size(), cacheSize);
+
+	OptimizeVertexCache(indices.data(), indices.size(), (uint32_t)meshData.Vertices.size(), cacheSize);
+	if (reorderVertices)
+		OptimizeVertexFetch(meshData.Vertices, indices.data(), indices.size());
+
+	stats.After = AnalyzeVertexCache(indices.data(), indices.size(), (uint32_t)meshData.Vertices.size(), cacheSize);
+
+	return stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reorders indexed triangle lists for the GPU: the triangles for the post-transform vertex cache
+// and then the vertices for the vertex fetch. Only needs the indices (and the vertices to move them),
+// so it runs at load time as well as in headless tools.
+
+// Vertices the post-transform cache is optimised for. Real caches vary, 16 does well on most of them.
+const int gDefaultVertexCacheSize = 16;
+
+struct VertexCacheStats
+{
+	// Average cache miss ratio: vertices transformed per triangle.
+	// 3 is the worst, big closed meshes can get close to 0.5.
+	float Acmr = 0.0f;
+
+	// Average transform to vertex ratio: vertices transformed per vertex of the mesh, 1 is the best
+	float Atvr = 0.0f;
+};
+
+struct MeshOptimizationStats
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
+
+// Simulates a FIFO post-transform cache of cacheSize vertices drawing the triangles
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, int cacheSize = gDefaultVertexCacheSize);
+
+// Reorders the triangles (keeping their winding) so they reuse the vertices in a cache of cacheSize vertices, with Tipsify:
+// triangles are emitted in fans around a vertex, and the next fan is the one around the vertex that is still in the cache
+// with the most triangles left. Runs in linear time. Keeps the order it was given if that one does better.
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount, int cacheSize = gDefaultVertexCacheSize);
+
+// Rewrites the indices so the vertices are numbered in the order the triangles first use them and returns that numbering
+// in remap (the new index of every vertex, ~0u for vertices no triangle uses) and the number of used vertices.
+uint32_t BuildVertexFetchRemap(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+// Reorders the vertices in the order the triangles (best optimised for the vertex cache first) use them,
+// so the vertex fetch reads them mostly sequentially. Vertices no triangle uses are removed.
+template<typename TVertex>
+void OptimizeVertexFetch(std::vector<TVertex>& vertices, uint32_t* indices, size_t indexCount);
+
+// Optimises a generated mesh for the vertex cache and, when reorderVertices is set, for the vertex fetch.
+// Meshes whose vertex order means something (like the row major grid height fields are built from) keep it.
+MeshOptimizationStats OptimizeMesh(GeometryGenerator::MeshData& meshData, bool reorderVertices, int cacheSize = gDefaultVertexCacheSize);
+
+template<typename TVertex>
+void OptimizeVertexFetch(std::vector<TVertex>& vertices, uint32_t* indices, size_t indexCount)
+{
+	std::vector<uint32_t> remap;
+	uint32_t usedVertexCount = BuildVertexFetchRemap(indices, indexCount, (uint32_t)vertices.size(), remap);
+
+	std::vector<TVertex> remappedVertices(usedVertexCount);
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		if (remap[i] != ~0u)
+			remappedVertices[remap[i]] = vertices[i];
+	}
+
+	vertices.swap(remappedVertices);
+}
@@ -0,0 +1,160 @@
+#include "MeshOptimizerReport.h"
+#include "MeshOptimizer.h"
+#include "VertexPacking.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// Reads a model in the text format of the skull: the vertex and triangle counts,
+// then a position and normal per vertex and three indices per triangle
+static bool LoadModel(const std::string& fileName, GeometryGenerator::MeshData& meshData)
+{
+	std::ifstream fin(fileName);
+	if (!fin)
+		return false;
+
+	uint32_t vertexCount = 0;
+	uint32_t triangleCount = 0;
+	std::string ignore;
+
+	fin >> ignore >> vertexCount;
+	fin >> ignore >> triangleCount;
+	fin >> ignore >> ignore >> ignore >> ignore;
+
+	meshData.Vertices.resize(vertexCount);
+	for (GeometryGenerator::Vertex& vertex : meshData.Vertices)
+	{
+		fin >> vertex.Position.x >> vertex.Position.y >> vertex.Position.z;
+		fin >> vertex.Normal.x >> vertex.Normal.y >> vertex.Normal.z;
+	}
+
+	fin >> ignore >> ignore >> ignore;
+
+	meshData.Indices32.resize(3 * (size_t)triangleCount);
+	for (uint32_t& index : meshData.Indices32)
+		fin >> index;
+
+	if (!fin)
+		return false;
+
+	for (uint32_t index : meshData.Indices32)
+	{
+		if (index >= vertexCount)
+			return false;
+	}
+
+	return true;
+}
+
+struct ReportMesh
+{
+	std::string Name;
+	GeometryGenerator::MeshData MeshData;
+	bool ReorderVertices = true;
+};
+
+static void PrintReport(const ReportMesh& mesh, int cacheSize)
+{
+	GeometryGenerator::MeshData meshData = mesh.MeshData;
+	size_t vertexCount = meshData.Vertices.size();
+	MeshOptimizationStats stats = OptimizeMesh(meshData, mesh.ReorderVertices, cacheSize);
+
+	std::cout << std::left << std::setw(24) << mesh.Name << std::right
+		<< std::setw(10) << meshData.Indices32.size() / 3
+		<< std::setw(10) << vertexCount
+		<< std::setw(10) << stats.Before.Acmr << std::setw(10) << stats.After.Acmr
+		<< std::setw(10) << stats.Before.Atvr << std::setw(10) << stats.After.Atvr << std::endl;
+}
+
+// The size and the largest error of the vertices packed with PackVertices, quantized like the apps do (uniform scale)
+static void PrintPackingReport(const ReportMesh& mesh)
+{
+	const std::vector<GeometryGenerator::Vertex>& vertices = mesh.MeshData.Vertices;
+
+	VertexQuantization quantization = ComputeVertexQuantization(&vertices[0].Position, sizeof(GeometryGenerator::Vertex), vertices.size(), true);
+	std::vector<PackedVertex> packedVertices = PackVertices(vertices, quantization);
+	VertexPackingError error = MeasurePackingError(vertices, packedVertices, quantization);
+
+	std::cout << std::left << std::setw(24) << mesh.Name << std::right
+		<< std::setw(10) << vertices.size() * sizeof(GeometryGenerator::Vertex)
+		<< std::setw(10) << packedVertices.size() * sizeof(PackedVertex)
+		<< std::setw(12) << error.Position
+		<< std::setw(12) << error.Normal
+		<< std::setw(12) << error.TangentU
+		<< std::setw(12) << error.TexC << std::endl;
+}
+
+int RunMeshOptimizerReport(const std::vector<std::string>& arguments)
+{
+	int cacheSize = gDefaultVertexCacheSize;
+	std::vector<std::string> fileNames;
+
+	for (size_t i = 0; i < arguments.size(); ++i)
+	{
+		if (arguments[i] != "--cache-size")
+		{
+			fileNames.push_back(arguments[i]);
+			continue;
+		}
+
+		cacheSize = i + 1 < arguments.size() ? std::atoi(arguments[++i].c_str()) : 0;
+		if (cacheSize <= 0)
+		{
+			std::cerr << "--cache-size needs a number of vertices" << std::endl;
+			return 1;
+		}
+	}
+
+	int result = 0;
+	std::vector<ReportMesh> meshes;
+
+	if (fileNames.empty())
+	{
+		// The meshes and parameters the apps use. Grids keep their row major vertices, like in MeshCache.
+		GeometryGenerator geoGen;
+		meshes.push_back({ "box", geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3), true });
+		meshes.push_back({ "grid 60x40", geoGen.CreateGrid(20.0f, 30.0f, 60, 40), false });
+		meshes.push_back({ "grid 50x50", geoGen.CreateGrid(160.0f, 160.0f, 50, 50), false });
+		meshes.push_back({ "sphere", geoGen.CreateSphere(0.5f, 20, 20), true });
+		meshes.push_back({ "cylinder", geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20), true });
+	}
+
+	for (const std::string& fileName : fileNames)
+	{
+		ReportMesh mesh;
+		mesh.Name = fileName;
+
+		// Empty models can't be packed, they have no bounds
+		if (!LoadModel(fileName, mesh.MeshData) || mesh.MeshData.Vertices.empty())
+		{
+			std::cerr << fileName << " can't be read" << std::endl;
+			result = 1;
+			continue;
+		}
+
+		meshes.push_back(std::move(mesh));
+	}
+
+	std::cout << "Post-transform cache of " << cacheSize << " vertices" << std::endl;
+	std::cout << std::left << std::setw(24) << "mesh" << std::right
+		<< std::setw(10) << "triangles" << std::setw(10) << "vertices"
+		<< std::setw(20) << "ACMR before/after" << std::setw(20) << "ATVR before/after" << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+
+	for (const ReportMesh& mesh : meshes)
+		PrintReport(mesh, cacheSize);
+
+	std::cout << std::endl << "Vertex packing, largest errors (normal and tangent in degrees)" << std::endl;
+	std::cout << std::left << std::setw(24) << "mesh" << std::right
+		<< std::setw(20) << "bytes before/after"
+		<< std::setw(12) << "position" << std::setw(12) << "normal"
+		<< std::setw(12) << "tangent" << std::setw(12) << "uv" << std::endl;
+	std::cout << std::setprecision(6);
+
+	for (const ReportMesh& mesh : meshes)
+		PrintPackingReport(mesh);
+
+	return result;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// The offline side of MeshOptimizer and VertexPacking: optimises and packs meshes without a window or a device
+// and prints their ACMR and ATVR before and after, and the size and error of their packed vertices, to the console.
+// Run the app with
+//     --mesh-report [--cache-size N] [model files...]
+// or, on any platform, the MeshOptimizerReport console tool of CMakeLists.txt with the same arguments.
+// The model files are in the text format of ../data/Models/skull.txt, without any the meshes of GeometryGenerator are reported.
+// Returns the exit code of the app: 0, or 1 if an argument or a file can't be read.
+int RunMeshOptimizerReport(const std::vector<std::string>& arguments);
@@ -0,0 +1,8 @@
+#include "MeshOptimizerReport.h"
+
+// Entry point of the standalone MeshOptimizerReport console tool (see CMakeLists.txt),
+// it takes the same arguments as the app does after --mesh-report.
+int main(int argc, char* argv[])
+{
+	return RunMeshOptimizerReport(std::vector<std::string>(argv + 1, argv + argc));
+}
@@ -0,0 +1,422 @@
+#include "MeshSimplifier.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+// A pass collapses the edges cheaper than this much of the error of the last edge it needs to reach the target,
+// as many edges are blocked by collapses next to them
+static const float s_PassErrorSlack = 1.5f;
+
+MeshSimplifier::MeshSimplifier(const MeshSource& source):
+	m_Source(source),
+	m_Indices(source.Indices, source.Indices + source.IndexCount / 3 * 3)
+{
+	this->ClassifyVertices();
+	this->BuildQuadrics();
+}
+
+MeshSimplifier::~MeshSimplifier()
+{
+
+}
+
+void MeshSimplifier::ClassifyVertices()
+{
+	uint32_t vertexCount = m_Source.VertexCount;
+	m_Locked.assign(vertexCount, 0);
+
+	// Vertices that share their position with others sit on a seam
+	std::vector<uint32_t> byPosition(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		byPosition[vertex] = vertex;
+
+	std::sort(byPosition.begin(), byPosition.end(), [this](uint32_t a, uint32_t b)
+	{
+		return memcmp(&m_Source.GetPosition(a), &m_Source.GetPosition(b), sizeof(XMFLOAT3)) < 0;
+	});
+
+	// Positions are compared by their bits, positions welded on the same seam are bitwise equal
+	std::vector<uint32_t> positionIds(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; ++i)
+	{
+		bool samePosition = i > 0 && memcmp(&m_Source.GetPosition(byPosition[i]), &m_Source.GetPosition(byPosition[i - 1]), sizeof(XMFLOAT3)) == 0;
+		positionIds[byPosition[i]] = samePosition ? positionIds[byPosition[i - 1]] : byPosition[i];
+
+		if (samePosition)
+		{
+			m_Locked[byPosition[i]] = 1;
+			m_Locked[byPosition[i - 1]] = 1;
+		}
+	}
+
+	// Edges (between positions, so seams don't count as borders) used by a single triangle are on a border,
+	// edges used by more than two triangles are non-manifold, their vertices are locked the same way
+	std::vector<uint64_t> edges;
+	edges.reserve(m_Indices.size());
+
+	for (size_t i = 0; i < m_Indices.size(); i += 3)
+	{
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t a = positionIds[m_Indices[i + corner]];
+			uint32_t b = positionIds[m_Indices[i + (corner + 1) % 3]];
+			if (a != b)
+				edges.push_back(((uint64_t)std::min<uint32_t>(a, b) << 32) | std::max<uint32_t>(a, b));
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+
+	std::vector<char> lockedPositions(vertexCount, 0);
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t j = i + 1;
+		while (j < edges.size() && edges[j] == edges[i])
+			++j;
+
+		if (j - i != 2)
+		{
+			lockedPositions[edges[i] >> 32] = 1;
+			lockedPositions[edges[i] & 0xFFFFFFFF] = 1;
+		}
+
+		i = j;
+	}
+
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		if (lockedPositions[positionIds[vertex]])
+			m_Locked[vertex] = 1;
+	}
+}
+
+void MeshSimplifier::BuildQuadrics()
+{
+	m_Quadrics.assign(m_Source.VertexCount, Quadric());
+
+	for (size_t i = 0; i < m_Indices.size(); i += 3)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&m_Source.GetPosition(m_Indices[i + 0]));
+		XMVECTOR p1 = XMLoadFloat3(&m_Source.GetPosition(m_Indices[i + 1]));
+		XMVECTOR p2 = XMLoadFloat3(&m_Source.GetPosition(m_Indices[i + 2]));
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		float doubleArea = XMVectorGetX(XMVector3Length(normal));
+		if (doubleArea == 0.0f)
+			continue;
+
+		normal = XMVectorScale(normal, 1.0f / doubleArea);
+
+		// The squared distance to the plane n.p + d = 0 is p^T (n n^T) p + 2 d n.p + d^2, weighted by the area
+		// so big triangles count more. Errors are divided by the weight to stay squared distances.
+		float nx = XMVectorGetX(normal);
+		float ny = XMVectorGetY(normal);
+		float nz = XMVectorGetZ(normal);
+		float d = -XMVectorGetX(XMVector3Dot(normal, p0));
+		float weight = 0.5f * doubleArea;
+
+		Quadric plane;
+		plane.A00 = weight * nx * nx;
+		plane.A11 = weight * ny * ny;
+		plane.A22 = weight * nz * nz;
+		plane.A01 = weight * nx * ny;
+		plane.A02 = weight * nx * nz;
+		plane.A12 = weight * ny * nz;
+		plane.B0 = weight * nx * d;
+		plane.B1 = weight * ny * d;
+		plane.B2 = weight * nz * d;
+		plane.C = weight * d * d;
+		plane.Weight = weight;
+
+		for (int corner = 0; corner < 3; ++corner)
+			AddQuadric(m_Quadrics[m_Indices[i + corner]], plane);
+	}
+}
+
+void MeshSimplifier::BuildAdjacency()
+{
+	uint32_t vertexCount = m_Source.VertexCount;
+
+	m_AdjacencyOffsets.assign(vertexCount + 1, 0);
+	for (uint32_t vertex : m_Indices)
+		++m_AdjacencyOffsets[vertex + 1];
+
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+		m_AdjacencyOffsets[vertex + 1] += m_AdjacencyOffsets[vertex];
+
+	m_Adjacency.resize(m_Indices.size());
+	std::vector<uint32_t> adjacencyEnds(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < m_Indices.size(); ++i)
+		m_Adjacency[adjacencyEnds[m_Indices[i]]++] = (uint32_t)(i / 3);
+}
+
+void MeshSimplifier::AddQuadric(Quadric& quadric, const Quadric& other)
+{
+	quadric.A00 += other.A00;
+	quadric.A11 += other.A11;
+	quadric.A22 += other.A22;
+	quadric.A01 += other.A01;
+	quadric.A02 += other.A02;
+	quadric.A12 += other.A12;
+	quadric.B0 += other.B0;
+	quadric.B1 += other.B1;
+	quadric.B2 += other.B2;
+	quadric.C += other.C;
+	quadric.Weight += other.Weight;
+}
+
+float MeshSimplifier::EvaluateQuadric(const Quadric& quadric, const XMFLOAT3& position)
+{
+	float x = position.x;
+	float y = position.y;
+	float z = position.z;
+
+	float error = quadric.A00 * x * x + quadric.A11 * y * y + quadric.A22 * z * z +
+		2.0f * (quadric.A01 * x * y + quadric.A02 * x * z + quadric.A12 * y * z) +
+		2.0f * (quadric.B0 * x + quadric.B1 * y + quadric.B2 * z) + quadric.C;
+
+	return quadric.Weight > 0.0f ? std::max<float>(error / quadric.Weight, 0.0f) : 0.0f;
+}
+
+static bool HasCorner(const uint32_t* corners, uint32_t vertex)
+{
+	return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex;
+}
+
+// True if moving from onto to turns one of the triangles around from (that doesn't collapse with the edge) over
+bool MeshSimplifier::IsCollapseFlipping(uint32_t from, uint32_t to) const
+{
+	XMVECTOR toPosition = XMLoadFloat3(&m_Source.GetPosition(to));
+
+	for (uint32_t k = m_AdjacencyOffsets[from]; k < m_AdjacencyOffsets[from + 1]; ++k)
+	{
+		const uint32_t* corners = &m_Indices[m_Adjacency[k] * 3];
+		if (HasCorner(corners, to))
+			continue;
+
+		XMVECTOR p[3];
+		for (int corner = 0; corner < 3; ++corner)
+			p[corner] = XMLoadFloat3(&m_Source.GetPosition(corners[corner]));
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			if (corners[corner] == from)
+				p[corner] = toPosition;
+		}
+
+		XMVECTOR newNormal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+		if (XMVectorGetX(XMVector3Dot(normal, newNormal)) <= 0.0f)
+			return true;
+	}
+
+	return false;
+}
+
+// True if from and to have more neighbours in common than the vertices opposite their edge:
+// the collapse would pinch the surface together there and make it non-manifold
+bool MeshSimplifier::IsCollapsePinching(uint32_t from, uint32_t to) const
+{
+	uint32_t edgeTriangleCount = 0;
+	uint32_t sharedNeighbourCount = 0;
+
+	for (uint32_t k = m_AdjacencyOffsets[from]; k < m_AdjacencyOffsets[from + 1]; ++k)
+	{
+		const uint32_t* corners = &m_Indices[m_Adjacency[k] * 3];
+		if (HasCorner(corners, to))
+			++edgeTriangleCount;
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t neighbour = corners[corner];
+			if (neighbour == from || neighbour == to)
+				continue;
+
+			// Neighbours are counted at their first triangle around from
+			bool seen = false;
+			for (uint32_t l = m_AdjacencyOffsets[from]; l < k && !seen; ++l)
+				seen = HasCorner(&m_Indices[m_Adjacency[l] * 3], neighbour);
+
+			bool shared = false;
+			for (uint32_t l = m_AdjacencyOffsets[to]; l < m_AdjacencyOffsets[to + 1] && !shared; ++l)
+				shared = HasCorner(&m_Indices[m_Adjacency[l] * 3], neighbour);
+
+			if (!seen && shared)
+				++sharedNeighbourCount;
+		}
+	}
+
+	return sharedNeighbourCount > edgeTriangleCount;
+}
+
+void MeshSimplifier::Simplify(size_t targetIndexCount)
+{
+	std::vector<char> touched(m_Source.VertexCount);
+	std::vector<uint32_t> remap(m_Source.VertexCount);
+
+	// Every pass collapses a set of edges that are apart from each other, so the triangles around
+	// a collapse are the ones the adjacency was built from when it is checked
+	while (m_Indices.size() > targetIndexCount)
+	{
+		this->BuildAdjacency();
+
+		m_Collapses.clear();
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				uint32_t a = m_Indices[i + corner];
+				uint32_t b = m_Indices[i + (corner + 1) % 3];
+
+				// Edges inside the mesh are seen from both of their triangles, the other way around in the second one.
+				// Edges on borders and seams are seen once, but their vertices are locked.
+				if (a > b)
+					continue;
+
+				if (!m_Locked[a])
+					m_Collapses.push_back(Collapse{ a, b, 0.0f });
+
+				if (!m_Locked[b])
+					m_Collapses.push_back(Collapse{ b, a, 0.0f });
+			}
+		}
+
+		if (m_Collapses.empty())
+			break;
+
+		for (Collapse& collapse : m_Collapses)
+		{
+			Quadric quadric = m_Quadrics[collapse.From];
+			AddQuadric(quadric, m_Quadrics[collapse.To]);
+
+			collapse.Error = this->EvaluateQuadric(quadric, m_Source.GetPosition(collapse.To));
+		}
+
+		std::sort(m_Collapses.begin(), m_Collapses.end(), [](const Collapse& a, const Collapse& b)
+		{
+			if (a.Error != b.Error)
+				return a.Error < b.Error;
+
+			return a.From != b.From ? a.From < b.From : a.To < b.To;
+		});
+
+		// A collapse inside the mesh removes two triangles
+		size_t triangleCount = m_Indices.size() / 3;
+		size_t collapseGoal = std::max<size_t>((triangleCount - targetIndexCount / 3) / 2, 1);
+		float errorLimit = m_Collapses[std::min<size_t>(collapseGoal, m_Collapses.size()) - 1].Error * s_PassErrorSlack;
+
+		std::fill(touched.begin(), touched.end(), 0);
+		for (uint32_t vertex = 0; vertex < m_Source.VertexCount; ++vertex)
+			remap[vertex] = vertex;
+
+		size_t collapseCount = 0;
+		for (const Collapse& collapse : m_Collapses)
+		{
+			if (collapseCount >= collapseGoal || collapse.Error > errorLimit)
+				break;
+
+			if (touched[collapse.From] || touched[collapse.To])
+				continue;
+
+			if (this->IsCollapsePinching(collapse.From, collapse.To) || this->IsCollapseFlipping(collapse.From, collapse.To))
+				continue;
+
+			remap[collapse.From] = collapse.To;
+
+			AddQuadric(m_Quadrics[collapse.To], m_Quadrics[collapse.From]);
+
+			m_MaxSquaredError = std::max<float>(m_MaxSquaredError, collapse.Error);
+
+			// The triangles around from change, none of their vertices can collapse again in this pass
+			for (uint32_t k = m_AdjacencyOffsets[collapse.From]; k < m_AdjacencyOffsets[collapse.From + 1]; ++k)
+			{
+				const uint32_t* corners = &m_Indices[m_Adjacency[k] * 3];
+				touched[corners[0]] = 1;
+				touched[corners[1]] = 1;
+				touched[corners[2]] = 1;
+			}
+
+			++collapseCount;
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		// Triangles that had the collapsed edges are degenerate now and are dropped
+		size_t indexCount = 0;
+		for (size_t i = 0; i < m_Indices.size(); i += 3)
+		{
+			uint32_t a = remap[m_Indices[i + 0]];
+			uint32_t b = remap[m_Indices[i + 1]];
+			uint32_t c = remap[m_Indices[i + 2]];
+
+			if (a == b || b == c || c == a)
+				continue;
+
+			m_Indices[indexCount++] = a;
+			m_Indices[indexCount++] = b;
+			m_Indices[indexCount++] = c;
+		}
+
+		m_Indices.resize(indexCount);
+	}
+}
+
+const std::vector<uint32_t>& MeshSimplifier::GetIndices() const
+{
+	return m_Indices;
+}
+
+float MeshSimplifier::GetError() const
+{
+	return std::sqrt(m_MaxSquaredError);
+}
+
+std::vector<MeshLod> BuildLodChain(const MeshSource& source, const std::vector<float>& triangleRatios)
+{
+	std::vector<MeshLod> lods(triangleRatios.size());
+	MeshSimplifier simplifier(source);
+
+	size_t triangleCount = source.IndexCount / 3;
+	for (size_t i = 0; i < triangleRatios.size(); ++i)
+	{
+		assert(i == 0 || triangleRatios[i] <= triangleRatios[i - 1]);
+
+		simplifier.Simplify((size_t)(triangleCount * triangleRatios[i]) * 3);
+
+		lods[i].Indices = simplifier.GetIndices();
+		lods[i].Error = simplifier.GetError();
+	}
+
+	return lods;
+}
+
+std::vector<std::vector<MeshLod>> BuildLodChains(const std::vector<MeshSource>& sources, const std::vector<float>& triangleRatios)
+{
+	std::vector<std::vector<MeshLod>> chains(sources.size());
+
+	TaskScheduler::Get().ParallelFor(0, (int)sources.size(), 1,
+		[&](int meshBegin, int meshEnd)
+	{
+		for (int i = meshBegin; i < meshEnd; ++i)
+			chains[i] = BuildLodChain(sources[i], triangleRatios);
+	});
+
+	return chains;
+}
+
+int SelectLod(const std::vector<float>& lodErrors, float distance, float pixelsPerUnit, float maxPixelError)
+{
+	// The errors grow along the chain, the first LOD that is too coarse ends it
+	int lod = 0;
+	while (lod + 1 < (int)lodErrors.size() && lodErrors[lod + 1] * pixelsPerUnit <= maxPixelError * distance)
+		++lod;
+
+	return lod;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "MeshSource.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Simplifies indexed triangle meshes with the quadric error metric (Garland and Heckbert): edges are collapsed
+// in the order of the squared distance the collapse moves the surface away from the planes of the triangles
+// it came from. Collapses move a vertex onto one of its neighbours, so a simplified mesh is new indices into
+// the same vertices and its LODs can be drawn as more submeshes of the same vertex and index buffers.
+// Vertices on open borders and seams (several vertices at the same position, like the texture seam of a sphere)
+// never move, so the LODs keep their outlines and don't tear along seams.
+
+class MeshSimplifier
+{
+public:
+	explicit MeshSimplifier(const MeshSource& source);
+	MeshSimplifier(const MeshSimplifier& other) = delete;
+	MeshSimplifier& operator=(const MeshSimplifier& other) = delete;
+	~MeshSimplifier();
+
+	// Collapses edges until there are at most targetIndexCount indices or no edge can collapse anymore.
+	// Can be called again with smaller targets to continue from the result, the quadrics carry on,
+	// so the error stays relative to the original mesh.
+	void Simplify(size_t targetIndexCount);
+
+	const std::vector<uint32_t>& GetIndices() const;
+
+	// The error of the collapses so far, in the units of the positions: the largest root mean square distance of a collapsed
+	// vertex to the planes of the original triangles it replaces, weighted by their areas. It is what the surface moved
+	// on average where it moved the most, single points of the original surface can be further away.
+	float GetError() const;
+
+private:
+	struct Quadric
+	{
+		float A00, A11, A22, A01, A02, A12;
+		float B0, B1, B2;
+		float C;
+		float Weight;
+	};
+
+	struct Collapse
+	{
+		uint32_t From;
+		uint32_t To;
+		float Error;
+	};
+
+	void ClassifyVertices();
+	void BuildQuadrics();
+	void BuildAdjacency();
+	bool IsCollapsePinching(uint32_t from, uint32_t to) const;
+	bool IsCollapseFlipping(uint32_t from, uint32_t to) const;
+
+	static void AddQuadric(Quadric& quadric, const Quadric& other);
+	static float EvaluateQuadric(const Quadric& quadric, const DirectX::XMFLOAT3& position);
+
+private:
+	MeshSource m_Source;
+
+	std::vector<uint32_t> m_Indices;
+	std::vector<Quadric> m_Quadrics;
+	std::vector<char> m_Locked;
+
+	// The triangles around every vertex, those of vertex v are [m_AdjacencyOffsets[v], m_AdjacencyOffsets[v + 1])
+	std::vector<uint32_t> m_AdjacencyOffsets;
+	std::vector<uint32_t> m_Adjacency;
+
+	std::vector<Collapse> m_Collapses;
+	float m_MaxSquaredError = 0.0f;
+};
+
+// A LOD of a mesh: its indices (into the vertices of the full mesh) and its error (see MeshSimplifier::GetError)
+struct MeshLod
+{
+	std::vector<uint32_t> Indices;
+	float Error = 0.0f;
+};
+
+// Simplifies the mesh to every triangle ratio (the triangle count of a LOD relative to the full mesh) in turn,
+// each LOD continuing from the one before. A LOD is as small as the locked vertices let it get,
+// which can be bigger than its ratio.
+std::vector<MeshLod> BuildLodChain(const MeshSource& source, const std::vector<float>& triangleRatios = { 0.5f, 0.25f, 0.125f });
+
+// Builds the LOD chains of several meshes in parallel, a task per mesh
+std::vector<std::vector<MeshLod>> BuildLodChains(const std::vector<MeshSource>& sources, const std::vector<float>& triangleRatios = { 0.5f, 0.25f, 0.125f });
+
+// The coarsest LOD whose error (see MeshSimplifier::GetError) is at most maxPixelError pixels on screen.
+// lodErrors has the error of every LOD of the chain, starting with the full mesh (0).
+// pixelsPerUnit is the size in pixels of one unit at distance 1 from the camera:
+// half the viewport height times the [1][1] element of the projection matrix.
+int SelectLod(const std::vector<float>& lodErrors, float distance, float pixelsPerUnit, float maxPixelError = 1.0f);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <DirectXMath.h>
+
+// The part of an indexed triangle mesh that mesh processing (meshlets, simplification) works on:
+// its indices and the positions of its vertices, positionStride bytes apart
+// (the size of the vertex for positions inside interleaved vertices).
+struct MeshSource
+{
+	MeshSource() = default;
+	explicit MeshSource(const GeometryGenerator::MeshData& meshData):
+		Indices(meshData.Indices32.data()),
+		IndexCount(meshData.Indices32.size()),
+		Positions(meshData.Vertices.empty() ? nullptr : &meshData.Vertices[0].Position),
+		PositionStride(sizeof(GeometryGenerator::Vertex)),
+		VertexCount((uint32_t)meshData.Vertices.size())
+	{
+
+	}
+
+	const DirectX::XMFLOAT3& GetPosition(uint32_t vertex) const
+	{
+		return *reinterpret_cast<const DirectX::XMFLOAT3*>(reinterpret_cast<const uint8_t*>(Positions) + vertex * PositionStride);
+	}
+
+	const uint32_t* Indices = nullptr;
+	size_t IndexCount = 0;
+	const DirectX::XMFLOAT3* Positions = nullptr;
+	size_t PositionStride = sizeof(DirectX::XMFLOAT3);
+	uint32_t VertexCount = 0;
+};
@@ -0,0 +1,242 @@
+#include "MeshletBuilder.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+// Limits of D3D12 mesh shaders, the local indices of a meshlet are bytes
+static const uint32_t s_MaxMeshletVertices = 256;
+static const uint32_t s_MaxMeshletTriangles = 256;
+
+// Meshlets whose triangle normals spread wider than this (the cosine of the angle between the axis
+// and the normal furthest from it) can't be back-facing as a whole for any useful range of views
+static const float s_MinConeSpread = 0.1f;
+
+static MeshletBounds ComputeMeshletBounds(const MeshSource& source, const MeshletMesh& mesh, const Meshlet& meshlet)
+{
+	MeshletBounds bounds;
+
+	const uint32_t* vertices = mesh.VertexIndices.data() + meshlet.VertexOffset;
+	const uint8_t* triangles = mesh.TriangleIndices.data() + meshlet.TriangleOffset * 3;
+
+	// Sphere around the center of the box around the vertices
+	XMFLOAT3 boxMin = source.GetPosition(vertices[0]);
+	XMFLOAT3 boxMax = boxMin;
+
+	for (uint32_t i = 1; i < meshlet.VertexCount; ++i)
+	{
+		const XMFLOAT3& position = source.GetPosition(vertices[i]);
+
+		boxMin.x = std::min<float>(boxMin.x, position.x);
+		boxMin.y = std::min<float>(boxMin.y, position.y);
+		boxMin.z = std::min<float>(boxMin.z, position.z);
+		boxMax.x = std::max<float>(boxMax.x, position.x);
+		boxMax.y = std::max<float>(boxMax.y, position.y);
+		boxMax.z = std::max<float>(boxMax.z, position.z);
+	}
+
+	XMVECTOR center = XMVectorScale(XMVectorAdd(XMLoadFloat3(&boxMin), XMLoadFloat3(&boxMax)), 0.5f);
+
+	float radius = 0.0f;
+	for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+	{
+		XMVECTOR position = XMLoadFloat3(&source.GetPosition(vertices[i]));
+		radius = std::max<float>(radius, XMVectorGetX(XMVector3Length(XMVectorSubtract(position, center))));
+	}
+
+	XMStoreFloat3(&bounds.Center, center);
+	bounds.Radius = radius;
+
+	// The cone axis is the average of the triangle normals (clockwise triangles are front-facing, like D3D culls them),
+	// degenerate triangles face nowhere and are skipped
+	XMVECTOR normals[s_MaxMeshletTriangles];
+	XMVECTOR corners[s_MaxMeshletTriangles];
+	uint32_t normalCount = 0;
+	XMVECTOR normalSum = XMVectorZero();
+
+	for (uint32_t t = 0; t < meshlet.TriangleCount; ++t)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&source.GetPosition(vertices[triangles[t * 3 + 0]]));
+		XMVECTOR p1 = XMLoadFloat3(&source.GetPosition(vertices[triangles[t * 3 + 1]]));
+		XMVECTOR p2 = XMLoadFloat3(&source.GetPosition(vertices[triangles[t * 3 + 2]]));
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+		float length = XMVectorGetX(XMVector3Length(normal));
+		if (length == 0.0f)
+			continue;
+
+		normals[normalCount] = XMVectorScale(normal, 1.0f / length);
+		corners[normalCount] = p0;
+		normalSum = XMVectorAdd(normalSum, normals[normalCount]);
+		++normalCount;
+	}
+
+	bounds.ConeApex = bounds.Center;
+	bounds.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	bounds.ConeCutoff = 1.0f;
+
+	float normalSumLength = XMVectorGetX(XMVector3Length(normalSum));
+	if (normalCount == 0 || normalSumLength == 0.0f)
+		return bounds;
+
+	XMVECTOR axis = XMVectorScale(normalSum, 1.0f / normalSumLength);
+
+	float minDot = 1.0f;
+	for (uint32_t t = 0; t < normalCount; ++t)
+		minDot = std::min<float>(minDot, XMVectorGetX(XMVector3Dot(axis, normals[t])));
+
+	XMStoreFloat3(&bounds.ConeAxis, axis);
+	if (minDot <= s_MinConeSpread)
+		return bounds;
+
+	// The apex is moved back along the axis until it is behind the plane of every triangle,
+	// so a camera in the cone is behind all of them however far it is from the meshlet
+	float maxDistance = 0.0f;
+	for (uint32_t t = 0; t < normalCount; ++t)
+	{
+		float distance = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, corners[t]), normals[t])) / XMVectorGetX(XMVector3Dot(axis, normals[t]));
+		maxDistance = std::max<float>(maxDistance, distance);
+	}
+
+	XMStoreFloat3(&bounds.ConeApex, XMVectorSubtract(center, XMVectorScale(axis, maxDistance)));
+	bounds.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+
+	return bounds;
+}
+
+MeshletMesh BuildMeshlets(const MeshSource& source, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	assert(maxVertices >= 3 && maxVertices <= s_MaxMeshletVertices);
+	assert(maxTriangles >= 1 && maxTriangles <= s_MaxMeshletTriangles);
+
+	MeshletMesh mesh;
+
+	size_t triangleCount = source.IndexCount / 3;
+	if (triangleCount == 0 || source.VertexCount == 0)
+		return mesh;
+
+	mesh.Meshlets.reserve(triangleCount / maxTriangles + 1);
+	mesh.TriangleIndices.reserve(triangleCount * 3);
+
+	// The local index of every vertex in the meshlet being filled, ~0u for those that aren't in it
+	std::vector<uint32_t> localIndices(source.VertexCount, ~0u);
+
+	Meshlet meshlet = {};
+
+	for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		const uint32_t* corners = source.Indices + triangle * 3;
+		assert(corners[0] < source.VertexCount && corners[1] < source.VertexCount && corners[2] < source.VertexCount);
+
+		uint32_t newVertexCount = (localIndices[corners[0]] == ~0u) +
+			(localIndices[corners[1]] == ~0u && corners[1] != corners[0]) +
+			(localIndices[corners[2]] == ~0u && corners[2] != corners[0] && corners[2] != corners[1]);
+
+		if (meshlet.VertexCount + newVertexCount > maxVertices || meshlet.TriangleCount + 1u > maxTriangles)
+		{
+			for (uint32_t i = 0; i < meshlet.VertexCount; ++i)
+				localIndices[mesh.VertexIndices[meshlet.VertexOffset + i]] = ~0u;
+
+			mesh.Meshlets.push_back(meshlet);
+
+			meshlet.VertexOffset += meshlet.VertexCount;
+			meshlet.TriangleOffset += meshlet.TriangleCount;
+			meshlet.VertexCount = 0;
+			meshlet.TriangleCount = 0;
+		}
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t& localIndex = localIndices[corners[corner]];
+			if (localIndex == ~0u)
+			{
+				localIndex = meshlet.VertexCount++;
+				mesh.VertexIndices.push_back(corners[corner]);
+			}
+
+			mesh.TriangleIndices.push_back((uint8_t)localIndex);
+		}
+
+		++meshlet.TriangleCount;
+	}
+
+	mesh.Meshlets.push_back(meshlet);
+
+	mesh.Bounds.resize(mesh.Meshlets.size());
+	for (size_t i = 0; i < mesh.Meshlets.size(); ++i)
+		mesh.Bounds[i] = ComputeMeshletBounds(source, mesh, mesh.Meshlets[i]);
+
+	return mesh;
+}
+
+std::vector<MeshletMesh> BuildMeshlets(const std::vector<MeshSource>& sources, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	std::vector<MeshletMesh> meshes(sources.size());
+
+	TaskScheduler::Get().ParallelFor(0, (int)sources.size(), 1,
+		[&](int meshBegin, int meshEnd)
+	{
+		for (int i = meshBegin; i < meshEnd; ++i)
+			meshes[i] = BuildMeshlets(sources[i], maxVertices, maxTriangles);
+	});
+
+	return meshes;
+}
+
+static XMFLOAT4 NormalizePlane(float a, float b, float c, float d)
+{
+	float length = std::sqrt(a * a + b * b + c * c);
+	return XMFLOAT4(a / length, b / length, c / length, d / length);
+}
+
+MeshletCullView CreateMeshletCullView(const XMFLOAT4X4& worldViewProj, const XMFLOAT3& cameraPosition)
+{
+	MeshletCullView view;
+
+	// Clip space is where -w <= x <= w, -w <= y <= w and 0 <= z <= w, every bound is a plane in the space of the mesh:
+	// with clip = p * M, clip.x is p dotted with the first column of M and so on
+	const float (&m)[4][4] = worldViewProj.m;
+
+	view.FrustumPlanes[0] = NormalizePlane(m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0]);	// Left
+	view.FrustumPlanes[1] = NormalizePlane(m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0]);	// Right
+	view.FrustumPlanes[2] = NormalizePlane(m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1]);	// Bottom
+	view.FrustumPlanes[3] = NormalizePlane(m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1]);	// Top
+	view.FrustumPlanes[4] = NormalizePlane(m[0][2], m[1][2], m[2][2], m[3][2]);												// Near
+	view.FrustumPlanes[5] = NormalizePlane(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]);	// Far
+
+	view.CameraPosition = cameraPosition;
+
+	return view;
+}
+
+bool IsMeshletVisible(const MeshletBounds& bounds, const MeshletCullView& view)
+{
+	const XMFLOAT3& center = bounds.Center;
+
+	for (const XMFLOAT4& plane : view.FrustumPlanes)
+	{
+		if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -bounds.Radius)
+			return false;
+	}
+
+	if (bounds.ConeCutoff >= 1.0f)
+		return true;
+
+	XMFLOAT3 direction(bounds.ConeApex.x - view.CameraPosition.x, bounds.ConeApex.y - view.CameraPosition.y, bounds.ConeApex.z - view.CameraPosition.z);
+	float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+	float axisDot = direction.x * bounds.ConeAxis.x + direction.y * bounds.ConeAxis.y + direction.z * bounds.ConeAxis.z;
+
+	return axisDot < bounds.ConeCutoff * distance;
+}
+
+void CullMeshlets(const MeshletMesh& mesh, const MeshletCullView& view, std::vector<uint32_t>& visibleMeshlets)
+{
+	for (size_t i = 0; i < mesh.Bounds.size(); ++i)
+	{
+		if (IsMeshletVisible(mesh.Bounds[i], view))
+			visibleMeshlets.push_back((uint32_t)i);
+	}
+}
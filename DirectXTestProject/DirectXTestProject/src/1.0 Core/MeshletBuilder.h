@@ -0,0 +1,72 @@
+#pragma once
+
+#include "MeshSource.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+// Splits indexed triangle meshes into meshlets (small clusters of triangles) that can be culled on their own,
+// for mesh shader style pipelines or for culling clusters on the CPU before they are submitted.
+
+// Limits that fit the mesh shaders of most GPUs
+const uint32_t gMeshletMaxVertices = 64;
+const uint32_t gMeshletMaxTriangles = 124;
+
+struct Meshlet
+{
+	uint32_t VertexOffset;		// First vertex of the meshlet in MeshletMesh::VertexIndices
+	uint32_t TriangleOffset;	// First triangle of the meshlet in MeshletMesh::TriangleIndices (3 entries per triangle)
+	uint16_t VertexCount;
+	uint16_t TriangleCount;
+};
+
+// Bounds of a meshlet, in the space of the mesh
+struct MeshletBounds
+{
+	DirectX::XMFLOAT3 Center;
+	float Radius;
+
+	// Every triangle of the meshlet faces away from a camera in the back-facing cone: the cone around -ConeAxis
+	// with its apex at ConeApex and the cosine of its half angle as the cutoff. A cutoff of 1 means the triangles
+	// face too many ways for the meshlet to ever be back-facing as a whole.
+	DirectX::XMFLOAT3 ConeApex;
+	float ConeCutoff;
+	DirectX::XMFLOAT3 ConeAxis;
+};
+
+// The meshlets of a mesh. A meshlet's triangles index into its vertices, which index into the vertices of the mesh:
+// triangle t of meshlet m has the mesh vertices VertexIndices[m.VertexOffset + TriangleIndices[3 * (m.TriangleOffset + t) + corner]].
+struct MeshletMesh
+{
+	std::vector<Meshlet> Meshlets;
+	std::vector<MeshletBounds> Bounds;
+	std::vector<uint32_t> VertexIndices;
+	std::vector<uint8_t> TriangleIndices;
+};
+
+// Fills meshlets with the triangles in the order of the indices, a meshlet is finished when the next triangle
+// doesn't fit anymore. Triangles ordered for the vertex cache (see OptimizeVertexCache) give compact meshlets.
+// maxVertices and maxTriangles can be at most 256.
+MeshletMesh BuildMeshlets(const MeshSource& source, uint32_t maxVertices = gMeshletMaxVertices, uint32_t maxTriangles = gMeshletMaxTriangles);
+
+// Builds the meshlets of several meshes in parallel, a task per mesh
+std::vector<MeshletMesh> BuildMeshlets(const std::vector<MeshSource>& sources, uint32_t maxVertices = gMeshletMaxVertices, uint32_t maxTriangles = gMeshletMaxTriangles);
+
+// A view to cull meshlets against, in the space of the mesh
+struct MeshletCullView
+{
+	DirectX::XMFLOAT4 FrustumPlanes[6];		// Inside is where dot(plane.xyz, p) + plane.w >= 0
+	DirectX::XMFLOAT3 CameraPosition;
+};
+
+// worldViewProj takes the mesh's vertices to clip space (as row vectors, before it is transposed for a shader),
+// cameraPosition is the camera in the space of the mesh.
+MeshletCullView CreateMeshletCullView(const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT3& cameraPosition);
+
+// False if the meshlet's bounding sphere is outside the frustum or the camera is in its back-facing cone
+bool IsMeshletVisible(const MeshletBounds& bounds, const MeshletCullView& view);
+
+// Appends the indices of the meshlets of mesh that are visible
+void CullMeshlets(const MeshletMesh& mesh, const MeshletCullView& view, std::vector<uint32_t>& visibleMeshlets);
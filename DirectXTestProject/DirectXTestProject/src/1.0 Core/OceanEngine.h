@@ -0,0 +1,93 @@
+#pragma once
+
+#include "OceanSolver.h"
+#include "WaveEngine.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <DirectXMath.h>
+
+// Ocean that outputs its surface as vertices of type TVertex, the layout is described by the same
+// WaveVertexTraits as for WaveEngine. The normals and tangents come from the analytic slopes of the waves.
+template<typename TVertex>
+class OceanEngine : public OceanSolver
+{
+public:
+	using Vertex = TVertex;
+	using Traits = WaveVertexTraits<TVertex>;
+
+	explicit OceanEngine(const OceanSettings& settings);
+	OceanEngine(const OceanEngine& other) = delete;
+	OceanEngine& operator=(const OceanEngine& other) = delete;
+	~OceanEngine();
+
+	using OceanSolver::Update;
+
+	// Same as Update, but also writes the vertices of the surface into vertices
+	// (GetVertexCount() of them, e.g. the mapped vertex buffer of the current frame).
+	void Update(float dTime, TVertex* vertices);
+
+	// Writes the vertices of the current surface into vertices, or only those of the rows [rowBegin, rowEnd)
+	void WriteVertices(TVertex* vertices);
+	void WriteVertices(TVertex* vertices, int rowBegin, int rowEnd);
+};
+
+template<typename TVertex>
+OceanEngine<TVertex>::OceanEngine(const OceanSettings& settings):
+	OceanSolver(settings)
+{
+
+}
+
+template<typename TVertex>
+OceanEngine<TVertex>::~OceanEngine()
+{
+
+}
+
+template<typename TVertex>
+void OceanEngine<TVertex>::Update(float dTime, TVertex* vertices)
+{
+	this->Update(dTime);
+
+	if (vertices)
+		this->WriteVertices(vertices);
+}
+
+template<typename TVertex>
+void OceanEngine<TVertex>::WriteVertices(TVertex* vertices)
+{
+	this->WriteVertices(vertices, 0, m_NumRows);
+}
+
+template<typename TVertex>
+void OceanEngine<TVertex>::WriteVertices(TVertex* vertices, int rowBegin, int rowEnd)
+{
+	assert(rowBegin >= 0 && rowEnd <= m_NumRows);
+
+	int rowsPerChunk = std::max<int>(1, 4096 / m_NumColumns);
+
+	TaskScheduler::Get().ParallelFor(rowBegin, rowEnd, rowsPerChunk,
+		[this, vertices](int rowBegin, int rowEnd)
+	{
+		const DirectX::XMFLOAT3 flatNormal(0.0f, 1.0f, 0.0f);
+		const DirectX::XMFLOAT3 flatTangent(1.0f, 0.0f, 0.0f);
+		const DirectX::XMFLOAT4 black(0.0f, 0.0f, 0.0f, 1.0f);
+
+		// Whole vertices are written in order, the destination usually is write-combined upload memory
+		for (int idx = rowBegin * m_NumColumns; idx < rowEnd * m_NumColumns; ++idx)
+		{
+			DirectX::XMFLOAT3 position = this->GetPosition(idx);
+
+			TVertex vertex;
+			Traits::Write(vertex,
+				position,
+				Traits::HasNormal ? this->GetNormal(idx) : flatNormal,
+				Traits::HasTangent ? this->GetTangentX(idx) : flatTangent,
+				Traits::HasColor ? Traits::GetColor(position.y) : black);
+
+			vertices[idx] = vertex;
+		}
+	});
+}
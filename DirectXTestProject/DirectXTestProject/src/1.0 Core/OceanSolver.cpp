@@ -0,0 +1,454 @@
+#include "OceanSolver.h"
+#include "CpuFeatures.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
+
+using namespace DirectX;
+
+static const double s_Pi = 3.14159265358979323846;
+static const double s_Gravity = 9.81;
+
+// Inputs and outputs of the per frame spectrum, all arrays are indexed by wave
+struct SpectrumEvaluation
+{
+	const float* CosTermRe;
+	const float* CosTermIm;
+	const float* SinTermRe;
+	const float* SinTermIm;
+	const float* Frequency;
+	const float* Kx;
+	const float* Kz;
+	const float* DisplacementX;
+	const float* DisplacementZ;
+
+	float* Re[3];
+	float* Im[3];
+
+	float Turns;	// Time / repeat period
+};
+
+typedef void(*EvaluateSpectrumFn)(const SpectrumEvaluation&, int, int);
+
+// sin and cos of turns * 2 pi. The angle is reduced to [-pi/4, pi/4] around a multiple of pi/2,
+// where the minimax polynomials of Cephes' sinf and cosf are accurate to about an ulp.
+static void SinCosTurns(float turns, float& sine, float& cosine)
+{
+	turns = turns - std::floor(turns + 0.5f);
+	float quadrant = std::floor(turns * 4.0f + 0.5f);
+	float x = (turns - quadrant * 0.25f) * 6.28318530718f;
+	float z = x * x;
+
+	float s = ((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z * x + x;
+	float c = ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+
+	// sin(q pi/2 + x) and cos(q pi/2 + x) for the quadrants q = -2..2
+	bool swap = quadrant == 1.0f || quadrant == -1.0f;
+	bool half = quadrant == 2.0f || quadrant == -2.0f;
+	bool negateSine = half || quadrant == -1.0f;
+	bool negateCosine = half || quadrant == 1.0f;
+
+	sine = swap ? c : s;
+	cosine = swap ? s : c;
+	sine = negateSine ? -sine : sine;
+	cosine = negateCosine ? -cosine : cosine;
+}
+
+// H = CosTerm * cos(w t) + SinTerm * sin(w t), then the three FFT planes:
+// (1 - kx) * H = H + i * (i kx H) for the heights and x-slopes,
+// (Dx + i kz) * H for the z-slopes and x-displacements and -i Dz H for the z-displacements.
+static void EvaluateSpectrumScalar(const SpectrumEvaluation& evaluation, int begin, int end)
+{
+	for (int i = begin; i < end; ++i)
+	{
+		float sine, cosine;
+		SinCosTurns(evaluation.Frequency[i] * evaluation.Turns, sine, cosine);
+
+		float hr = evaluation.CosTermRe[i] * cosine + evaluation.SinTermRe[i] * sine;
+		float hi = evaluation.CosTermIm[i] * cosine + evaluation.SinTermIm[i] * sine;
+
+		float kx = evaluation.Kx[i];
+		float kz = evaluation.Kz[i];
+		float dx = evaluation.DisplacementX[i];
+		float dz = evaluation.DisplacementZ[i];
+
+		evaluation.Re[0][i] = hr - kx * hr;
+		evaluation.Im[0][i] = hi - kx * hi;
+		evaluation.Re[1][i] = dx * hr - kz * hi;
+		evaluation.Im[1][i] = dx * hi + kz * hr;
+		evaluation.Re[2][i] = dz * hi;
+		evaluation.Im[2][i] = -(dz * hr);
+	}
+}
+
+#if CPU_X86
+CPU_TARGET("avx")
+static void EvaluateSpectrumAVX(const SpectrumEvaluation& evaluation, int begin, int end)
+{
+	const __m256 turnsPerFrequency = _mm256_set1_ps(evaluation.Turns);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 four = _mm256_set1_ps(4.0f);
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	const __m256 twoPi = _mm256_set1_ps(6.28318530718f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 minusOne = _mm256_set1_ps(-1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 minusTwo = _mm256_set1_ps(-2.0f);
+	const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+	int i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 turns = _mm256_mul_ps(_mm256_loadu_ps(evaluation.Frequency + i), turnsPerFrequency);
+		turns = _mm256_sub_ps(turns, _mm256_floor_ps(_mm256_add_ps(turns, half)));
+		__m256 quadrant = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(turns, four), half));
+		__m256 x = _mm256_mul_ps(_mm256_sub_ps(turns, _mm256_mul_ps(quadrant, quarter)), twoPi);
+		__m256 z = _mm256_mul_ps(x, x);
+
+		__m256 s = _mm256_mul_ps(_mm256_set1_ps(-1.9515295891e-4f), z);
+		s = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(s, _mm256_set1_ps(8.3321608736e-3f)), z), _mm256_set1_ps(1.6666654611e-1f)), z);
+		s = _mm256_add_ps(_mm256_mul_ps(s, x), x);
+
+		__m256 c = _mm256_mul_ps(_mm256_set1_ps(2.443315711809948e-5f), z);
+		c = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(c, _mm256_set1_ps(1.388731625493765e-3f)), z), _mm256_set1_ps(4.166664568298827e-2f));
+		c = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, z), z), _mm256_mul_ps(half, z)), one);
+
+		__m256 isOne = _mm256_cmp_ps(quadrant, one, _CMP_EQ_OQ);
+		__m256 isMinusOne = _mm256_cmp_ps(quadrant, minusOne, _CMP_EQ_OQ);
+		__m256 isHalf = _mm256_or_ps(_mm256_cmp_ps(quadrant, two, _CMP_EQ_OQ), _mm256_cmp_ps(quadrant, minusTwo, _CMP_EQ_OQ));
+		__m256 swap = _mm256_or_ps(isOne, isMinusOne);
+
+		__m256 sine = _mm256_blendv_ps(s, c, swap);
+		__m256 cosine = _mm256_blendv_ps(c, s, swap);
+		sine = _mm256_xor_ps(sine, _mm256_and_ps(_mm256_or_ps(isHalf, isMinusOne), signBit));
+		cosine = _mm256_xor_ps(cosine, _mm256_and_ps(_mm256_or_ps(isHalf, isOne), signBit));
+
+		__m256 hr = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(evaluation.CosTermRe + i), cosine),
+			_mm256_mul_ps(_mm256_loadu_ps(evaluation.SinTermRe + i), sine));
+		__m256 hi = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(evaluation.CosTermIm + i), cosine),
+			_mm256_mul_ps(_mm256_loadu_ps(evaluation.SinTermIm + i), sine));
+
+		__m256 kx = _mm256_loadu_ps(evaluation.Kx + i);
+		__m256 kz = _mm256_loadu_ps(evaluation.Kz + i);
+		__m256 dx = _mm256_loadu_ps(evaluation.DisplacementX + i);
+		__m256 dz = _mm256_loadu_ps(evaluation.DisplacementZ + i);
+
+		_mm256_storeu_ps(evaluation.Re[0] + i, _mm256_sub_ps(hr, _mm256_mul_ps(kx, hr)));
+		_mm256_storeu_ps(evaluation.Im[0] + i, _mm256_sub_ps(hi, _mm256_mul_ps(kx, hi)));
+		_mm256_storeu_ps(evaluation.Re[1] + i, _mm256_sub_ps(_mm256_mul_ps(dx, hr), _mm256_mul_ps(kz, hi)));
+		_mm256_storeu_ps(evaluation.Im[1] + i, _mm256_add_ps(_mm256_mul_ps(dx, hi), _mm256_mul_ps(kz, hr)));
+		_mm256_storeu_ps(evaluation.Re[2] + i, _mm256_mul_ps(dz, hi));
+		_mm256_storeu_ps(evaluation.Im[2] + i, _mm256_xor_ps(_mm256_mul_ps(dz, hr), signBit));
+	}
+
+	// Calling into the scalar code without a tail costs an AVX/SSE state transition per call
+	if (i < end)
+		EvaluateSpectrumScalar(evaluation, i, end);
+}
+#endif
+
+static EvaluateSpectrumFn GetEvaluateSpectrumFn()
+{
+#if CPU_X86
+	if (CpuFeatures::Get().AVX)
+		return &EvaluateSpectrumAVX;
+#endif
+
+	return &EvaluateSpectrumScalar;
+}
+
+static const EvaluateSpectrumFn s_EvaluateSpectrum = GetEvaluateSpectrumFn();
+
+OceanSolver::OceanSolver(const OceanSettings& settings):
+	WaterSurface(settings.Resolution + 1, settings.Resolution + 1, settings.PatchSize / settings.Resolution),
+	m_Settings(settings),
+	m_Resolution(settings.Resolution),
+	m_Fft(settings.Resolution)
+{
+	assert(settings.PatchSize > 0.0f && settings.RepeatPeriod > 0.0f);
+
+	int waveCount = m_Resolution * m_Resolution;
+
+	for (int plane = 0; plane < WavePlaneCount; ++plane)
+	{
+		m_WavesRe[plane].assign(waveCount, 0.0f);
+		m_WavesIm[plane].assign(waveCount, 0.0f);
+	}
+
+	m_Heights.assign(m_VertexCount, 0.0f);
+
+	this->InitSpectrum();
+	this->Evaluate();
+}
+
+OceanSolver::~OceanSolver()
+{
+
+}
+
+const OceanSettings& OceanSolver::GetSettings() const
+{
+	return m_Settings;
+}
+
+float OceanSolver::GetTime() const
+{
+	return m_Time;
+}
+
+int OceanSolver::GetWaveIndex(int idx) const
+{
+	int row = idx / m_NumColumns;
+	int column = idx - row * m_NumColumns;
+
+	// The last row and column are the first ones again
+	return (row % m_Resolution) * m_Resolution + column % m_Resolution;
+}
+
+XMFLOAT3 OceanSolver::GetPosition(int idx) const
+{
+	int row = idx / m_NumColumns;
+	int column = idx - row * m_NumColumns;
+	int wave = this->GetWaveIndex(idx);
+
+	return XMFLOAT3(
+		-m_HalfWidth + column * m_SpatialStep + m_WavesIm[SlopeZDisplacementX][wave],
+		m_WavesRe[HeightSlopeX][wave],
+		m_HalfDepth - row * m_SpatialStep + m_WavesRe[DisplacementZ][wave]);
+}
+
+float OceanSolver::GetHeight(int idx) const
+{
+	return m_Heights[idx];
+}
+
+HeightFieldView OceanSolver::GetHeightField() const
+{
+	HeightFieldView field;
+	field.Heights = m_Heights.data();
+	field.Format = HeightFieldFormat::Float32;
+	field.NumRows = m_NumRows;
+	field.NumColumns = m_NumColumns;
+	field.OriginX = -m_HalfWidth;
+	field.OriginZ = m_HalfDepth;
+	field.CellSizeX = m_SpatialStep;
+	field.CellSizeZ = m_SpatialStep;
+	return field;
+}
+
+XMFLOAT3 OceanSolver::GetNormal(int idx) const
+{
+	int wave = this->GetWaveIndex(idx);
+
+	XMFLOAT3 normal(-m_WavesIm[HeightSlopeX][wave], 1.0f, -m_WavesRe[SlopeZDisplacementX][wave]);
+	XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+	return normal;
+}
+
+XMFLOAT3 OceanSolver::GetTangentX(int idx) const
+{
+	int wave = this->GetWaveIndex(idx);
+
+	XMFLOAT3 tangent(1.0f, m_WavesIm[HeightSlopeX][wave], 0.0f);
+	XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&tangent)));
+	return tangent;
+}
+
+void OceanSolver::Update(float dTime)
+{
+	// Every wave has a whole number of periods in the repeat period, wrapping the time keeps the phases exact
+	m_Time = std::fmod(m_Time + dTime, m_Settings.RepeatPeriod);
+	if (m_Time < 0.0f)
+		m_Time += m_Settings.RepeatPeriod;
+
+	this->Evaluate();
+	m_LastUpdateStepCount = 1;
+}
+
+int OceanSolver::GetLastUpdateStepCount() const
+{
+	return m_LastUpdateStepCount;
+}
+
+void OceanSolver::InitSpectrum()
+{
+	const int n = m_Resolution;
+	const int waveCount = n * n;
+	const double dk = 2.0 * s_Pi / m_Settings.PatchSize;
+	const double baseFrequency = 2.0 * s_Pi / m_Settings.RepeatPeriod;
+
+	// h0(k) = (xr + i xi) / sqrt(2) * sqrt(spectrum * dk^2 / 2) with xr, xi standard normal.
+	// The mt19937 sequence is the same everywhere (unlike the standard distributions), so is the ocean of a seed.
+	std::mt19937 generator(m_Settings.Seed);
+	auto uniform = [&generator]()
+	{
+		return (generator() + 0.5) / 4294967296.0;
+	};
+
+	std::vector<float> h0Re(waveCount);
+	std::vector<float> h0Im(waveCount);
+
+	m_Kx.resize(waveCount);
+	m_Kz.resize(waveCount);
+	m_Frequency.resize(waveCount);
+
+	for (int row = 0; row < n; ++row)
+	{
+		for (int column = 0; column < n; ++column)
+		{
+			int i = row * n + column;
+
+			// Rows run down -z, so the wave of row n has kz = -n dk to line the FFT up with the grid
+			int waveRow = row < n / 2 ? row : row - n;
+			int waveColumn = column < n / 2 ? column : column - n;
+			double kx = dk * waveColumn;
+			double kz = -dk * waveRow;
+			double k = std::sqrt(kx * kx + kz * kz);
+
+			double radius = std::sqrt(-2.0 * std::log(uniform()));
+			double angle = 2.0 * s_Pi * uniform();
+
+			// The Nyquist waves have no -k partner and would leave an imaginary part, the mean height stays 0
+			double amplitude = 0.0;
+			if (row != n / 2 && column != n / 2 && k > 0.0)
+				amplitude = std::sqrt(this->GetSpectrum(kx, kz) * dk * dk * 0.25);
+
+			h0Re[i] = (float)(radius * std::cos(angle) * amplitude);
+			h0Im[i] = (float)(radius * std::sin(angle) * amplitude);
+
+			m_Kx[i] = (float)kx;
+			m_Kz[i] = (float)kz;
+			m_Frequency[i] = (float)std::floor(std::sqrt(s_Gravity * k) / baseFrequency);
+		}
+	}
+
+	// H(k, t) = h0(k) exp(i w t) + conj(h0(-k)) exp(-i w t), split into the terms of cos(w t) and sin(w t).
+	// H(-k, t) = conj(H(k, t)) holds exactly, so the waves come out real.
+	m_CosTermRe.resize(waveCount);
+	m_CosTermIm.resize(waveCount);
+	m_SinTermRe.resize(waveCount);
+	m_SinTermIm.resize(waveCount);
+	m_DisplacementX.resize(waveCount);
+	m_DisplacementZ.resize(waveCount);
+
+	for (int row = 0; row < n; ++row)
+	{
+		for (int column = 0; column < n; ++column)
+		{
+			int i = row * n + column;
+			int mirrored = ((n - row) % n) * n + (n - column) % n;
+
+			float a = h0Re[i];
+			float b = h0Im[i];
+			float c = h0Re[mirrored];
+			float d = -h0Im[mirrored];
+
+			m_CosTermRe[i] = a + c;
+			m_CosTermIm[i] = b + d;
+			m_SinTermRe[i] = d - b;
+			m_SinTermIm[i] = a - c;
+
+			// -Choppiness * k / |k| moves the points towards the crests (like Gerstner waves)
+			double k = std::sqrt((double)m_Kx[i] * m_Kx[i] + (double)m_Kz[i] * m_Kz[i]);
+			double displacement = k > 0.0 ? -m_Settings.Choppiness / k : 0.0;
+			m_DisplacementX[i] = (float)(displacement * m_Kx[i]);
+			m_DisplacementZ[i] = (float)(displacement * m_Kz[i]);
+		}
+	}
+}
+
+double OceanSolver::GetSpectrum(double kx, double kz) const
+{
+	double k = std::sqrt(kx * kx + kz * kz);
+	if (k < 1e-6)
+		return 0.0;
+
+	double windLength = std::sqrt(m_Settings.WindDirectionX * m_Settings.WindDirectionX + m_Settings.WindDirectionZ * m_Settings.WindDirectionZ);
+	double cosTheta = windLength > 0.0 ? (kx * m_Settings.WindDirectionX + kz * m_Settings.WindDirectionZ) / (k * windLength) : 1.0;
+	double smallWaveDamping = std::exp(-k * k * m_Settings.SmallWaveCutoff * m_Settings.SmallWaveCutoff);
+	double windSpeed = std::max<double>(m_Settings.WindSpeed, 0.01);
+
+	if (m_Settings.Spectrum == OceanSpectrum::Phillips)
+	{
+		// The largest waves the wind makes are about windSpeed^2 / g long
+		double largestWave = windSpeed * windSpeed / s_Gravity;
+		double kL = k * largestWave;
+
+		return m_Settings.Amplitude * std::exp(-1.0 / (kL * kL)) / (k * k * k * k) * cosTheta * cosTheta * smallWaveDamping;
+	}
+
+	// JONSWAP frequency spectrum, moved to wave numbers with the deep water dispersion w = sqrt(g k)
+	// and spread over the directions downwind with 2 / pi cos^2
+	if (cosTheta <= 0.0)
+		return 0.0;
+
+	double fetch = std::max<double>(m_Settings.Fetch, 1.0);
+	double omega = std::sqrt(s_Gravity * k);
+	double peakOmega = 22.0 * std::pow(s_Gravity * s_Gravity / (windSpeed * fetch), 1.0 / 3.0);
+	double alpha = 0.076 * std::pow(windSpeed * windSpeed / (fetch * s_Gravity), 0.22);
+	double sigma = omega <= peakOmega ? 0.07 : 0.09;
+	double peakDistance = (omega - peakOmega) / (sigma * peakOmega);
+	double enhancement = std::pow(m_Settings.PeakEnhancement, std::exp(-0.5 * peakDistance * peakDistance));
+	double peakRatio = peakOmega / omega;
+
+	double frequencySpectrum = alpha * s_Gravity * s_Gravity / std::pow(omega, 5.0) *
+		std::exp(-1.25 * peakRatio * peakRatio * peakRatio * peakRatio) * enhancement;
+	double dOmegaDk = s_Gravity / (2.0 * omega);
+
+	return frequencySpectrum * dOmegaDk / k * (2.0 / s_Pi) * cosTheta * cosTheta * smallWaveDamping;
+}
+
+void OceanSolver::Evaluate()
+{
+	const int n = m_Resolution;
+
+	SpectrumEvaluation evaluation;
+	evaluation.CosTermRe = m_CosTermRe.data();
+	evaluation.CosTermIm = m_CosTermIm.data();
+	evaluation.SinTermRe = m_SinTermRe.data();
+	evaluation.SinTermIm = m_SinTermIm.data();
+	evaluation.Frequency = m_Frequency.data();
+	evaluation.Kx = m_Kx.data();
+	evaluation.Kz = m_Kz.data();
+	evaluation.DisplacementX = m_DisplacementX.data();
+	evaluation.DisplacementZ = m_DisplacementZ.data();
+	evaluation.Turns = m_Time / m_Settings.RepeatPeriod;
+
+	for (int plane = 0; plane < WavePlaneCount; ++plane)
+	{
+		evaluation.Re[plane] = m_WavesRe[plane].data();
+		evaluation.Im[plane] = m_WavesIm[plane].data();
+	}
+
+	int rowsPerChunk = std::max<int>(1, 4096 / n);
+
+	TaskScheduler::Get().ParallelFor(0, n, rowsPerChunk,
+		[&evaluation, n](int rowBegin, int rowEnd)
+	{
+		s_EvaluateSpectrum(evaluation, rowBegin * n, rowEnd * n);
+	});
+
+	// Without choppiness the z-displacements are 0 and stay so
+	int planeCount = m_Settings.Choppiness != 0.0f ? WavePlaneCount : WavePlaneCount - 1;
+	m_Fft.Transform2D(evaluation.Re, evaluation.Im, planeCount, true);
+
+	const float* heights = m_WavesRe[HeightSlopeX].data();
+
+	for (int row = 0; row < m_NumRows; ++row)
+	{
+		const float* waveRow = heights + (row % n) * n;
+		float* heightRow = &m_Heights[row * m_NumColumns];
+
+		std::copy(waveRow, waveRow + n, heightRow);
+		heightRow[n] = waveRow[0];
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "WaterSurface.h"
+#include "Fft.h"
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+enum class OceanSpectrum : char
+{
+	Phillips = 0,	// Fully developed sea, scaled by Amplitude
+	Jonswap			// Fetch limited sea, scaled by the wind speed and fetch
+};
+
+struct OceanSettings
+{
+	int Resolution = 128;				// Waves per side of the patch, a power of two
+	float PatchSize = 128.0f;			// Side of the patch in world units (meters), the surface repeats after it
+
+	OceanSpectrum Spectrum = OceanSpectrum::Phillips;
+	float WindSpeed = 10.0f;			// Meters per second, 10 m above the sea
+	float WindDirectionX = 1.0f;		// Direction the wind blows to, doesn't need to be normalized
+	float WindDirectionZ = 0.0f;
+	float Amplitude = 0.0005f;			// Phillips constant
+	float Fetch = 100000.0f;			// JONSWAP: meters the wind blew over the water
+	float PeakEnhancement = 3.3f;		// JONSWAP: gamma
+	float SmallWaveCutoff = 0.1f;		// Waves shorter than about this (meters) are damped
+
+	float Choppiness = 1.0f;			// Scales the horizontal displacement that sharpens the crests, 0 for round waves
+	float RepeatPeriod = 200.0f;		// Seconds after which the surface repeats, every wave frequency is a multiple of 2 pi / RepeatPeriod
+	uint32_t Seed = 1;
+};
+
+// Ocean surface of the statistical wave model of Tessendorf ("Simulating Ocean Water"):
+// a sum of resolution x resolution sine waves whose amplitudes follow an ocean spectrum, evaluated per frame with inverse FFTs.
+// Unlike the finite difference solver it has no time step, an Update evaluates the waves at any time for O(N log N),
+// and the patch tiles seamlessly in space and (after the repeat period) in time.
+//
+// The grid has resolution + 1 points per side, the last row and column repeat the first ones so the patch can be tiled.
+// The points are displaced horizontally by the choppiness, GetPosition includes that displacement;
+// GetHeight and GetHeightField give the heights at the undisplaced grid points.
+class OceanSolver : public WaterSurface
+{
+public:
+	explicit OceanSolver(const OceanSettings& settings);
+	OceanSolver(const OceanSolver& other) = delete;
+	OceanSolver& operator=(const OceanSolver& other) = delete;
+	~OceanSolver();
+
+	const OceanSettings& GetSettings() const;
+
+	// Returns the seconds the surface is at, in [0, repeat period)
+	float GetTime() const;
+
+	DirectX::XMFLOAT3 GetPosition(int idx) const override;
+	float GetHeight(int idx) const override;
+	HeightFieldView GetHeightField() const override;
+
+	// Returns the normal of the grid point at index from the analytic slopes of the waves
+	DirectX::XMFLOAT3 GetNormal(int idx) const;
+
+	// Returns the unit tangent vector of the grid point at index in the local x-axis direction
+	DirectX::XMFLOAT3 GetTangentX(int idx) const;
+
+	// Evaluates the waves dTime seconds later
+	void Update(float dTime) override;
+
+	// An Update is one evaluation of the waves (1 step), whatever its dTime
+	int GetLastUpdateStepCount() const override;
+
+protected:
+	// Returns the index into the wave planes (resolution x resolution) of the grid point at index
+	int GetWaveIndex(int idx) const;
+
+private:
+	void InitSpectrum();
+
+	// Returns the spectrum (variance per wave number area) of the wave with wave number (kx, kz)
+	double GetSpectrum(double kx, double kz) const;
+
+	// Computes the spectra the inverse FFTs turn into the waves at the current time
+	void Evaluate();
+
+protected:
+	OceanSettings m_Settings;
+	int m_Resolution;
+
+	// The waves as resolution x resolution planes, two real ones per complex FFT plane:
+	// heights + i * x-slopes, z-slopes + i * x-displacements and z-displacements
+	enum WavePlane
+	{
+		HeightSlopeX = 0,
+		SlopeZDisplacementX,
+		DisplacementZ,
+
+		WavePlaneCount
+	};
+
+	std::vector<float> m_WavesRe[WavePlaneCount];
+	std::vector<float> m_WavesIm[WavePlaneCount];
+
+private:
+	Fft m_Fft;
+
+	float m_Time = 0.0f;
+	int m_LastUpdateStepCount = 0;
+
+	// The spectrum at time t is CosTerm * cos(w t) + SinTerm * sin(w t) per wave, with w = Frequency * 2 pi / RepeatPeriod
+	std::vector<float> m_CosTermRe;
+	std::vector<float> m_CosTermIm;
+	std::vector<float> m_SinTermRe;
+	std::vector<float> m_SinTermIm;
+	std::vector<float> m_Frequency;
+
+	// Wave numbers, and Choppiness * k / |k| for the displacements
+	std::vector<float> m_Kx;
+	std::vector<float> m_Kz;
+	std::vector<float> m_DisplacementX;
+	std::vector<float> m_DisplacementZ;
+
+	// Heights of the (resolution + 1)^2 grid points for GetHeightField
+	std::vector<float> m_Heights;
+};
@@ -0,0 +1,246 @@
+#include "TaskScheduler.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Scheduler and queue of the worker running on this thread, -1 for threads that aren't workers.
+static thread_local const TaskScheduler* s_WorkerScheduler = nullptr;
+static thread_local int s_WorkerIndex = -1;
+
+// All the hardware threads, std::thread::hardware_concurrency only counts the processor group of the process on older runtimes
+static int GetHardwareThreadCount()
+{
+#if defined(_WIN32)
+	return (int)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+	return (int)std::thread::hardware_concurrency();
+#endif
+}
+
+static void PinCurrentThread(int hardwareThread)
+{
+#if defined(_WIN32)
+	// An affinity mask only addresses the 64 hardware threads of a processor group, so machines with more
+	// are numbered across all the groups and the thread goes to the group its number falls in.
+	DWORD processorCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+	if (processorCount == 0)
+		return;
+
+	DWORD processor = (DWORD)hardwareThread % processorCount;
+	WORD groupCount = GetActiveProcessorGroupCount();
+
+	for (WORD group = 0; group < groupCount; ++group)
+	{
+		DWORD groupProcessorCount = GetActiveProcessorCount(group);
+		if (processor < groupProcessorCount)
+		{
+			GROUP_AFFINITY affinity = {};
+			affinity.Group = group;
+			affinity.Mask = KAFFINITY(1) << processor;
+			SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+			return;
+		}
+
+		processor -= groupProcessorCount;
+	}
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(hardwareThread % CPU_SETSIZE, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+	(void)hardwareThread;
+#endif
+}
+
+TaskScheduler::TaskScheduler(int workerCount, bool pinWorkers):
+	m_QueuedTaskCount(0),
+	m_Quit(false)
+{
+	if (workerCount <= 0)
+		workerCount = std::max<int>(GetHardwareThreadCount(), 1) - 1;
+
+	for (int i = 0; i < workerCount + 1; ++i)
+		m_Queues.push_back(std::make_unique<WorkQueue>());
+
+	m_Workers.reserve(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+		m_Workers.emplace_back(&TaskScheduler::WorkerMain, this, i, pinWorkers);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Quit = true;
+	}
+	m_SleepCondition.notify_all();
+
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+TaskScheduler& TaskScheduler::Get()
+{
+	static TaskScheduler scheduler;
+	return scheduler;
+}
+
+int TaskScheduler::GetWorkerCount() const
+{
+	return (int)m_Workers.size();
+}
+
+int TaskScheduler::GetCurrentQueueIndex() const
+{
+	return s_WorkerScheduler == this ? s_WorkerIndex : (int)m_Workers.size();
+}
+
+void TaskScheduler::Push(Task&& task)
+{
+	WorkQueue& queue = *m_Queues[GetCurrentQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.push_back(std::move(task));
+	}
+
+	++m_QueuedTaskCount;
+
+	// Taking the sleep mutex makes sure a worker that just found no work
+	// is either still before its check or already waiting, so the notify can't get lost.
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+	}
+	m_SleepCondition.notify_one();
+}
+
+bool TaskScheduler::TryPop(int queueIndex, Task& task)
+{
+	WorkQueue& queue = *m_Queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+
+	if (queue.Tasks.empty())
+		return false;
+
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	--m_QueuedTaskCount;
+	return true;
+}
+
+bool TaskScheduler::TrySteal(int thiefIndex, Task& task)
+{
+	int queueCount = (int)m_Queues.size();
+
+	for (int i = 1; i < queueCount; ++i)
+	{
+		WorkQueue& queue = *m_Queues[(thiefIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+
+		if (queue.Tasks.empty())
+			continue;
+
+		// Steal the oldest task, it is most likely the biggest piece of work left in that queue.
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		--m_QueuedTaskCount;
+		return true;
+	}
+
+	return false;
+}
+
+bool TaskScheduler::ExecuteOne()
+{
+	if (m_QueuedTaskCount.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	int queueIndex = GetCurrentQueueIndex();
+
+	Task task;
+	if (!TryPop(queueIndex, task) && !TrySteal(queueIndex, task))
+		return false;
+
+	Execute(task);
+	return true;
+}
+
+void TaskScheduler::Execute(Task& task)
+{
+	task.Function();
+	task.Group->m_PendingCount.fetch_sub(1, std::memory_order_release);
+}
+
+void TaskScheduler::WorkerMain(int workerIndex, bool pin)
+{
+	s_WorkerScheduler = this;
+	s_WorkerIndex = workerIndex;
+
+	// Leave hardware thread 0 to the main thread.
+	if (pin)
+		PinCurrentThread(workerIndex + 1);
+
+	for (;;)
+	{
+		if (ExecuteOne())
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_SleepCondition.wait(lock, [this]() { return m_Quit || m_QueuedTaskCount > 0; });
+
+		if (m_Quit && m_QueuedTaskCount == 0)
+			return;
+	}
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler):
+	m_Scheduler(scheduler),
+	m_PendingCount(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	this->Wait();
+}
+
+void TaskGroup::Run(std::function<void()> function)
+{
+	m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+
+	TaskScheduler::Task task;
+	task.Function = std::move(function);
+	task.Group = this;
+
+	// Without workers there is nobody to hand the task to.
+	if (m_Scheduler.m_Workers.empty())
+	{
+		m_Scheduler.Execute(task);
+		return;
+	}
+
+	m_Scheduler.Push(std::move(task));
+}
+
+void TaskGroup::Wait()
+{
+	int idleCount = 0;
+
+	while (m_PendingCount.load(std::memory_order_acquire) > 0)
+	{
+		// Help out instead of blocking, this is what makes nesting safe.
+		if (m_Scheduler.ExecuteOne())
+		{
+			idleCount = 0;
+			continue;
+		}
+
+		// Our remaining tasks are running on other threads, they are usually short.
+		if (++idleCount > 64)
+			std::this_thread::yield();
+	}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+// Portable work-stealing thread pool. This is the parallel primitive used by all CPU hot paths.
+// Every worker owns a deque: it pushes and pops its own tasks at the back (so nested work
+// runs depth first and stays in its caches) and other workers steal from the front when they run dry.
+// Threads that aren't workers (the main thread) push into a shared injection queue.
+// A thread that waits on a TaskGroup executes queued tasks instead of blocking,
+// so ParallelFor and TaskGroups can be nested freely.
+class TaskScheduler
+{
+public:
+	// workerCount <= 0 creates one worker per hardware thread minus one, as the calling thread helps out too.
+	// pinWorkers locks each worker to its own hardware thread.
+	explicit TaskScheduler(int workerCount = 0, bool pinWorkers = false);
+	TaskScheduler(const TaskScheduler& other) = delete;
+	TaskScheduler& operator=(const TaskScheduler& other) = delete;
+	~TaskScheduler();
+
+	// The engine-wide scheduler
+	static TaskScheduler& Get();
+
+	int GetWorkerCount() const;
+
+	// Splits [begin, end) into chunks of grainSize indices and calls function(chunkBegin, chunkEnd)
+	// for every chunk, in parallel. Returns when all chunks are done.
+	// Pick the grain size so a chunk is worth a few microseconds of work.
+	template<typename Function>
+	void ParallelFor(int begin, int end, int grainSize, const Function& function);
+
+private:
+	friend class TaskGroup;
+
+	struct Task
+	{
+		std::function<void()> Function;
+		TaskGroup* Group = nullptr;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	void Push(Task&& task);
+	bool TryPop(int queueIndex, Task& task);
+	bool TrySteal(int thiefIndex, Task& task);
+
+	// Executes one queued task on the calling thread, returns false if there was nothing to do.
+	bool ExecuteOne();
+	void Execute(Task& task);
+
+	int GetCurrentQueueIndex() const;
+	void WorkerMain(int workerIndex, bool pin);
+
+private:
+	std::vector<std::thread> m_Workers;
+
+	// One queue per worker, the last one is the injection queue for non-worker threads.
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+
+	std::atomic<int> m_QueuedTaskCount;
+	std::atomic<bool> m_Quit;
+
+	std::mutex m_SleepMutex;
+	std::condition_variable m_SleepCondition;
+};
+
+// A set of tasks that can be waited on together.
+// The destructor waits for all tasks that are still running.
+class TaskGroup
+{
+public:
+	explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::Get());
+	TaskGroup(const TaskGroup& other) = delete;
+	TaskGroup& operator=(const TaskGroup& other) = delete;
+	~TaskGroup();
+
+	void Run(std::function<void()> function);
+
+	// Executes queued tasks on the calling thread until all tasks of this group are done.
+	void Wait();
+
+private:
+	friend class TaskScheduler;
+
+	TaskScheduler& m_Scheduler;
+	std::atomic<int> m_PendingCount;
+};
+
+template<typename Function>
+void TaskScheduler::ParallelFor(int begin, int end, int grainSize, const Function& function)
+{
+	if (end <= begin)
+		return;
+
+	grainSize = std::max<int>(grainSize, 1);
+	int chunkCount = (end - begin - 1) / grainSize + 1;
+
+	if (chunkCount == 1 || m_Workers.empty())
+	{
+		function(begin, end);
+		return;
+	}
+
+	// Instead of queueing a task per chunk, queue a few tasks that keep grabbing chunks
+	// until none are left. Late tasks find nothing to do and return immediately,
+	// so an idle machine splits the range evenly and a busy one doesn't pay for the tasks it couldn't run.
+	std::atomic<int> nextChunk(0);
+	auto runChunks = [&]()
+	{
+		for (int chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+		{
+			int chunkBegin = begin + chunk * grainSize;
+			function(chunkBegin, std::min<int>(chunkBegin + grainSize, end));
+		}
+	};
+
+	TaskGroup group(*this);
+
+	int helperCount = std::min<int>(chunkCount - 1, (int)m_Workers.size());
+	for (int i = 0; i < helperCount; ++i)
+		group.Run(runChunks);
+
+	runChunks();
+	group.Wait();
+}
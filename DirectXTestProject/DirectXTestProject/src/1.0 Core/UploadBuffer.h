@@ -4,6 +4,7 @@
 #include <DirectX/d3dx12.h>
 #include <wrl.h>
 #include <memory.h>
+#include <cassert>
 #include "Utils.h"
 
 // Typically, the world matrix of an object will change when it moves/rotates/scales,
@@ -72,6 +73,15 @@ public:
 		memcpy(&m_MappedData[elementIndex*m_ElementByteSize], &data, sizeof(T));
 	}
 
+	// Returns the mapped elements, so producers can write them in place instead of going through CopyData.
+	// Only tightly packed buffers can be addressed like this, constant buffer elements are padded.
+	// Note this is usually write-combined memory: write it sequentially and never read from it.
+	T* GetMappedData() const
+	{
+		assert(!m_IsConstantBuffer);
+		return reinterpret_cast<T*>(m_MappedData);
+	}
+
 private:
 	Microsoft::WRL::ComPtr<ID3D12Resource> m_UploadBuffer;
 	BYTE* m_MappedData = nullptr;
@@ -4,6 +4,7 @@
 #include <wrl.h>
 #include <d3d12.h>
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 
@@ -229,6 +230,13 @@ struct LightningVertex
 	DirectX::XMFLOAT3 Normal;
 };
 
+// LightningVertex packed by VertexPacking: snorm position in the bounds of the mesh and octahedral normal
+struct PackedLightningVertex
+{
+	int16_t Position[4];
+	int16_t Normal[2];
+};
+
 const int gNumFrameResources = 3;
 
 struct Material
@@ -0,0 +1,693 @@
+#include "VertexPacking.h"
+#include "CpuFeatures.h"
+#include "HalfFloat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
+
+using namespace DirectX;
+
+static const float s_SnormScale = 32767.0f;
+
+static const float s_DegreesPerRadian = 180.0f / XM_PI;
+
+template<typename T>
+static T* Offset(T* pointer, size_t byteCount)
+{
+	return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(pointer) + byteCount);
+}
+
+// Rounds to nearest even like the SIMD conversions
+static int16_t FloatToSnorm16(float value)
+{
+	value = std::min<float>(std::max<float>(value, -1.0f), 1.0f);
+	return (int16_t)std::lrint(value * s_SnormScale);
+}
+
+// Like the GPU reads snorms, -32768 and -32767 are both -1
+static float Snorm16ToFloat(int16_t value)
+{
+	return std::max<float>((float)value / s_SnormScale, -1.0f);
+}
+
+static float SignNotZero(float value)
+{
+	return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+XMFLOAT4X4 VertexQuantization::GetDequantizeTransform() const
+{
+	return XMFLOAT4X4(
+		Extent.x, 0.0f, 0.0f, 0.0f,
+		0.0f, Extent.y, 0.0f, 0.0f,
+		0.0f, 0.0f, Extent.z, 0.0f,
+		Center.x, Center.y, Center.z, 1.0f);
+}
+
+VertexQuantization ComputeVertexQuantization(const XMFLOAT3* positions, size_t positionStride, size_t count, bool uniformScale)
+{
+	VertexQuantization quantization;
+	if (count == 0)
+		return quantization;
+
+	XMFLOAT3 boxMin = positions[0];
+	XMFLOAT3 boxMax = positions[0];
+
+	for (size_t i = 1; i < count; ++i)
+	{
+		const XMFLOAT3& position = *Offset(positions, i * positionStride);
+
+		boxMin.x = std::min<float>(boxMin.x, position.x);
+		boxMin.y = std::min<float>(boxMin.y, position.y);
+		boxMin.z = std::min<float>(boxMin.z, position.z);
+		boxMax.x = std::max<float>(boxMax.x, position.x);
+		boxMax.y = std::max<float>(boxMax.y, position.y);
+		boxMax.z = std::max<float>(boxMax.z, position.z);
+	}
+
+	quantization.Center = XMFLOAT3(0.5f * (boxMin.x + boxMax.x), 0.5f * (boxMin.y + boxMax.y), 0.5f * (boxMin.z + boxMax.z));
+	quantization.Extent = XMFLOAT3(0.5f * (boxMax.x - boxMin.x), 0.5f * (boxMax.y - boxMin.y), 0.5f * (boxMax.z - boxMin.z));
+
+	if (uniformScale)
+	{
+		float extent = std::max<float>(std::max<float>(quantization.Extent.x, quantization.Extent.y), quantization.Extent.z);
+		quantization.Extent = XMFLOAT3(extent, extent, extent);
+	}
+
+	// Flat meshes (like grids) have no extent across, any scale packs them to 0 there
+	if (quantization.Extent.x == 0.0f)
+		quantization.Extent.x = 1.0f;
+	if (quantization.Extent.y == 0.0f)
+		quantization.Extent.y = 1.0f;
+	if (quantization.Extent.z == 0.0f)
+		quantization.Extent.z = 1.0f;
+
+	return quantization;
+}
+
+typedef void(*PackPositionsFn)(const XMFLOAT3*, size_t, size_t, const VertexQuantization&, int16_t*, size_t);
+typedef void(*UnpackPositionsFn)(const int16_t*, size_t, size_t, const VertexQuantization&, XMFLOAT3*, size_t);
+typedef void(*PackUnitVectorsFn)(const XMFLOAT3*, size_t, size_t, int16_t*, size_t);
+typedef void(*UnpackUnitVectorsFn)(const int16_t*, size_t, size_t, XMFLOAT3*, size_t);
+typedef void(*PackTexCoordsFn)(const XMFLOAT2*, size_t, size_t, uint16_t*, size_t);
+typedef void(*UnpackTexCoordsFn)(const uint16_t*, size_t, size_t, XMFLOAT2*, size_t);
+
+static void PackPositionsScalar(const XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, int16_t* packed, size_t packedStride)
+{
+	const XMFLOAT3& center = quantization.Center;
+	XMFLOAT3 invExtent(1.0f / quantization.Extent.x, 1.0f / quantization.Extent.y, 1.0f / quantization.Extent.z);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const XMFLOAT3& position = *Offset(positions, i * positionStride);
+		int16_t* destination = Offset(packed, i * packedStride);
+
+		destination[0] = FloatToSnorm16((position.x - center.x) * invExtent.x);
+		destination[1] = FloatToSnorm16((position.y - center.y) * invExtent.y);
+		destination[2] = FloatToSnorm16((position.z - center.z) * invExtent.z);
+		destination[3] = 0;
+	}
+}
+
+static void UnpackPositionsScalar(const int16_t* packed, size_t packedStride, size_t count, const VertexQuantization& quantization, XMFLOAT3* positions, size_t positionStride)
+{
+	const XMFLOAT3& center = quantization.Center;
+	const XMFLOAT3& extent = quantization.Extent;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int16_t* source = Offset(packed, i * packedStride);
+		XMFLOAT3& position = *Offset(positions, i * positionStride);
+
+		position.x = Snorm16ToFloat(source[0]) * extent.x + center.x;
+		position.y = Snorm16ToFloat(source[1]) * extent.y + center.y;
+		position.z = Snorm16ToFloat(source[2]) * extent.z + center.z;
+	}
+}
+
+// The vector is projected onto the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper one
+// onto the square |x| + |y| <= 1 (Cigolle et al., A Survey of Efficient Representations for Independent Unit Vectors)
+static void PackUnitVectorsScalar(const XMFLOAT3* vectors, size_t vectorStride, size_t count, int16_t* packed, size_t packedStride)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const XMFLOAT3& vector = *Offset(vectors, i * vectorStride);
+		int16_t* destination = Offset(packed, i * packedStride);
+
+		float x = 0.0f;
+		float y = 0.0f;
+
+		float length = (std::fabs(vector.x) + std::fabs(vector.y)) + std::fabs(vector.z);
+		if (length > 0.0f)
+		{
+			x = vector.x / length;
+			y = vector.y / length;
+		}
+
+		if (vector.z < 0.0f)
+		{
+			float foldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float foldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		destination[0] = FloatToSnorm16(x);
+		destination[1] = FloatToSnorm16(y);
+	}
+}
+
+static void UnpackUnitVectorsScalar(const int16_t* packed, size_t packedStride, size_t count, XMFLOAT3* vectors, size_t vectorStride)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int16_t* source = Offset(packed, i * packedStride);
+		XMFLOAT3& vector = *Offset(vectors, i * vectorStride);
+
+		float x = Snorm16ToFloat(source[0]);
+		float y = Snorm16ToFloat(source[1]);
+		float z = (1.0f - std::fabs(x)) - std::fabs(y);
+
+		if (z < 0.0f)
+		{
+			float unfoldedX = (1.0f - std::fabs(y)) * SignNotZero(x);
+			float unfoldedY = (1.0f - std::fabs(x)) * SignNotZero(y);
+			x = unfoldedX;
+			y = unfoldedY;
+		}
+
+		float length = std::sqrt((x * x + y * y) + z * z);
+		vector = XMFLOAT3(x / length, y / length, z / length);
+	}
+}
+
+static void PackTexCoordsScalar(const XMFLOAT2* texCoords, size_t texCoordStride, size_t count, uint16_t* packed, size_t packedStride)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const XMFLOAT2& texCoord = *Offset(texCoords, i * texCoordStride);
+		uint16_t* destination = Offset(packed, i * packedStride);
+
+		destination[0] = FloatToHalf(texCoord.x);
+		destination[1] = FloatToHalf(texCoord.y);
+	}
+}
+
+static void UnpackTexCoordsScalar(const uint16_t* packed, size_t packedStride, size_t count, XMFLOAT2* texCoords, size_t texCoordStride)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint16_t* source = Offset(packed, i * packedStride);
+		*Offset(texCoords, i * texCoordStride) = XMFLOAT2(HalfToFloat(source[0]), HalfToFloat(source[1]));
+	}
+}
+
+#if CPU_X86
+// The kernels gather the attributes of 8 vertices into a register per component, the gather indices
+// are the offsets of the vertices in 32 bit words from the first one of the block
+CPU_TARGET("avx2")
+static __m256i GetGatherIndices(size_t stride)
+{
+	assert(stride % 4 == 0);
+	return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)(stride / 4)));
+}
+
+CPU_TARGET("avx2")
+static __m256i FloatToSnorm16AVX2(__m256 value)
+{
+	value = _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+	return _mm256_cvtps_epi32(_mm256_mul_ps(value, _mm256_set1_ps(s_SnormScale)));
+}
+
+// Sign extends the low or high 16 bits of every 32 bit word and reads it as a snorm
+CPU_TARGET("avx2")
+static __m256 LowSnorm16ToFloatAVX2(__m256i words)
+{
+	__m256i values = _mm256_srai_epi32(_mm256_slli_epi32(words, 16), 16);
+	return _mm256_max_ps(_mm256_div_ps(_mm256_cvtepi32_ps(values), _mm256_set1_ps(s_SnormScale)), _mm256_set1_ps(-1.0f));
+}
+
+CPU_TARGET("avx2")
+static __m256 HighSnorm16ToFloatAVX2(__m256i words)
+{
+	__m256i values = _mm256_srai_epi32(words, 16);
+	return _mm256_max_ps(_mm256_div_ps(_mm256_cvtepi32_ps(values), _mm256_set1_ps(s_SnormScale)), _mm256_set1_ps(-1.0f));
+}
+
+CPU_TARGET("avx2")
+static __m256 AbsAVX2(__m256 value)
+{
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value);
+}
+
+CPU_TARGET("avx2")
+static __m256 SignNotZeroAVX2(__m256 value)
+{
+	return _mm256_blendv_ps(_mm256_set1_ps(-1.0f), _mm256_set1_ps(1.0f), _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ));
+}
+
+CPU_TARGET("avx2")
+static void PackPositionsAVX2(const XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, int16_t* packed, size_t packedStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(positionStride);
+	const __m256i lowBits = _mm256_set1_epi32(0xFFFF);
+
+	const __m256 centerX = _mm256_set1_ps(quantization.Center.x);
+	const __m256 centerY = _mm256_set1_ps(quantization.Center.y);
+	const __m256 centerZ = _mm256_set1_ps(quantization.Center.z);
+	const __m256 invExtentX = _mm256_set1_ps(1.0f / quantization.Extent.x);
+	const __m256 invExtentY = _mm256_set1_ps(1.0f / quantization.Extent.y);
+	const __m256 invExtentZ = _mm256_set1_ps(1.0f / quantization.Extent.z);
+
+	alignas(32) uint32_t packedXY[8];
+	alignas(32) uint32_t packedZW[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float* block = reinterpret_cast<const float*>(Offset(positions, i * positionStride));
+
+		__m256 x = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(block + 0, gatherIndices, 4), centerX), invExtentX);
+		__m256 y = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(block + 1, gatherIndices, 4), centerY), invExtentY);
+		__m256 z = _mm256_mul_ps(_mm256_sub_ps(_mm256_i32gather_ps(block + 2, gatherIndices, 4), centerZ), invExtentZ);
+
+		// x and y go in the first 32 bits of the packed position, z and w in the second
+		__m256i xy = _mm256_or_si256(_mm256_and_si256(FloatToSnorm16AVX2(x), lowBits), _mm256_slli_epi32(FloatToSnorm16AVX2(y), 16));
+		__m256i zw = _mm256_and_si256(FloatToSnorm16AVX2(z), lowBits);
+
+		_mm256_store_si256(reinterpret_cast<__m256i*>(packedXY), xy);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(packedZW), zw);
+
+		for (int k = 0; k < 8; ++k)
+		{
+			int16_t* destination = Offset(packed, (i + k) * packedStride);
+			memcpy(destination, &packedXY[k], sizeof(uint32_t));
+			memcpy(destination + 2, &packedZW[k], sizeof(uint32_t));
+		}
+	}
+
+	// Calling into the scalar code without a tail costs an AVX/SSE state transition per call
+	if (i < count)
+		PackPositionsScalar(Offset(positions, i * positionStride), positionStride, count - i, quantization, Offset(packed, i * packedStride), packedStride);
+}
+
+CPU_TARGET("avx2")
+static void UnpackPositionsAVX2(const int16_t* packed, size_t packedStride, size_t count, const VertexQuantization& quantization, XMFLOAT3* positions, size_t positionStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(packedStride);
+
+	const __m256 centerX = _mm256_set1_ps(quantization.Center.x);
+	const __m256 centerY = _mm256_set1_ps(quantization.Center.y);
+	const __m256 centerZ = _mm256_set1_ps(quantization.Center.z);
+	const __m256 extentX = _mm256_set1_ps(quantization.Extent.x);
+	const __m256 extentY = _mm256_set1_ps(quantization.Extent.y);
+	const __m256 extentZ = _mm256_set1_ps(quantization.Extent.z);
+
+	alignas(32) float unpackedX[8];
+	alignas(32) float unpackedY[8];
+	alignas(32) float unpackedZ[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int* block = reinterpret_cast<const int*>(Offset(packed, i * packedStride));
+
+		__m256i xy = _mm256_i32gather_epi32(block + 0, gatherIndices, 4);
+		__m256i zw = _mm256_i32gather_epi32(block + 1, gatherIndices, 4);
+
+		_mm256_store_ps(unpackedX, _mm256_add_ps(_mm256_mul_ps(LowSnorm16ToFloatAVX2(xy), extentX), centerX));
+		_mm256_store_ps(unpackedY, _mm256_add_ps(_mm256_mul_ps(HighSnorm16ToFloatAVX2(xy), extentY), centerY));
+		_mm256_store_ps(unpackedZ, _mm256_add_ps(_mm256_mul_ps(LowSnorm16ToFloatAVX2(zw), extentZ), centerZ));
+
+		for (int k = 0; k < 8; ++k)
+			*Offset(positions, (i + k) * positionStride) = XMFLOAT3(unpackedX[k], unpackedY[k], unpackedZ[k]);
+	}
+
+	if (i < count)
+		UnpackPositionsScalar(Offset(packed, i * packedStride), packedStride, count - i, quantization, Offset(positions, i * positionStride), positionStride);
+}
+
+CPU_TARGET("avx2")
+static void PackUnitVectorsAVX2(const XMFLOAT3* vectors, size_t vectorStride, size_t count, int16_t* packed, size_t packedStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(vectorStride);
+	const __m256i lowBits = _mm256_set1_epi32(0xFFFF);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	alignas(32) uint32_t packedXY[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float* block = reinterpret_cast<const float*>(Offset(vectors, i * vectorStride));
+
+		__m256 vectorX = _mm256_i32gather_ps(block + 0, gatherIndices, 4);
+		__m256 vectorY = _mm256_i32gather_ps(block + 1, gatherIndices, 4);
+		__m256 vectorZ = _mm256_i32gather_ps(block + 2, gatherIndices, 4);
+
+		// Zero vectors divide to nans, they are packed as 0 like in the scalar code
+		__m256 length = _mm256_add_ps(_mm256_add_ps(AbsAVX2(vectorX), AbsAVX2(vectorY)), AbsAVX2(vectorZ));
+		__m256 nonZero = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+		__m256 x = _mm256_and_ps(_mm256_div_ps(vectorX, length), nonZero);
+		__m256 y = _mm256_and_ps(_mm256_div_ps(vectorY, length), nonZero);
+
+		__m256 foldedX = _mm256_mul_ps(_mm256_sub_ps(one, AbsAVX2(y)), SignNotZeroAVX2(x));
+		__m256 foldedY = _mm256_mul_ps(_mm256_sub_ps(one, AbsAVX2(x)), SignNotZeroAVX2(y));
+		__m256 lowerHalf = _mm256_cmp_ps(vectorZ, zero, _CMP_LT_OQ);
+		x = _mm256_blendv_ps(x, foldedX, lowerHalf);
+		y = _mm256_blendv_ps(y, foldedY, lowerHalf);
+
+		__m256i xy = _mm256_or_si256(_mm256_and_si256(FloatToSnorm16AVX2(x), lowBits), _mm256_slli_epi32(FloatToSnorm16AVX2(y), 16));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(packedXY), xy);
+
+		for (int k = 0; k < 8; ++k)
+			memcpy(Offset(packed, (i + k) * packedStride), &packedXY[k], sizeof(uint32_t));
+	}
+
+	if (i < count)
+		PackUnitVectorsScalar(Offset(vectors, i * vectorStride), vectorStride, count - i, Offset(packed, i * packedStride), packedStride);
+}
+
+CPU_TARGET("avx2")
+static void UnpackUnitVectorsAVX2(const int16_t* packed, size_t packedStride, size_t count, XMFLOAT3* vectors, size_t vectorStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(packedStride);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	alignas(32) float unpackedX[8];
+	alignas(32) float unpackedY[8];
+	alignas(32) float unpackedZ[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int* block = reinterpret_cast<const int*>(Offset(packed, i * packedStride));
+		__m256i xy = _mm256_i32gather_epi32(block, gatherIndices, 4);
+
+		__m256 x = LowSnorm16ToFloatAVX2(xy);
+		__m256 y = HighSnorm16ToFloatAVX2(xy);
+		__m256 z = _mm256_sub_ps(_mm256_sub_ps(one, AbsAVX2(x)), AbsAVX2(y));
+
+		__m256 unfoldedX = _mm256_mul_ps(_mm256_sub_ps(one, AbsAVX2(y)), SignNotZeroAVX2(x));
+		__m256 unfoldedY = _mm256_mul_ps(_mm256_sub_ps(one, AbsAVX2(x)), SignNotZeroAVX2(y));
+		__m256 lowerHalf = _mm256_cmp_ps(z, zero, _CMP_LT_OQ);
+		x = _mm256_blendv_ps(x, unfoldedX, lowerHalf);
+		y = _mm256_blendv_ps(y, unfoldedY, lowerHalf);
+
+		__m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+
+		_mm256_store_ps(unpackedX, _mm256_div_ps(x, length));
+		_mm256_store_ps(unpackedY, _mm256_div_ps(y, length));
+		_mm256_store_ps(unpackedZ, _mm256_div_ps(z, length));
+
+		for (int k = 0; k < 8; ++k)
+			*Offset(vectors, (i + k) * vectorStride) = XMFLOAT3(unpackedX[k], unpackedY[k], unpackedZ[k]);
+	}
+
+	if (i < count)
+		UnpackUnitVectorsScalar(Offset(packed, i * packedStride), packedStride, count - i, Offset(vectors, i * vectorStride), vectorStride);
+}
+
+CPU_TARGET("avx2,f16c")
+static void PackTexCoordsAVX2(const XMFLOAT2* texCoords, size_t texCoordStride, size_t count, uint16_t* packed, size_t packedStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(texCoordStride);
+
+	alignas(16) uint32_t packedUV[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const float* block = reinterpret_cast<const float*>(Offset(texCoords, i * texCoordStride));
+
+		__m128i u = _mm256_cvtps_ph(_mm256_i32gather_ps(block + 0, gatherIndices, 4), _MM_FROUND_TO_NEAREST_INT);
+		__m128i v = _mm256_cvtps_ph(_mm256_i32gather_ps(block + 1, gatherIndices, 4), _MM_FROUND_TO_NEAREST_INT);
+
+		_mm_store_si128(reinterpret_cast<__m128i*>(packedUV), _mm_unpacklo_epi16(u, v));
+		_mm_store_si128(reinterpret_cast<__m128i*>(packedUV + 4), _mm_unpackhi_epi16(u, v));
+
+		for (int k = 0; k < 8; ++k)
+			memcpy(Offset(packed, (i + k) * packedStride), &packedUV[k], sizeof(uint32_t));
+	}
+
+	if (i < count)
+		PackTexCoordsScalar(Offset(texCoords, i * texCoordStride), texCoordStride, count - i, Offset(packed, i * packedStride), packedStride);
+}
+
+CPU_TARGET("avx2,f16c")
+static void UnpackTexCoordsAVX2(const uint16_t* packed, size_t packedStride, size_t count, XMFLOAT2* texCoords, size_t texCoordStride)
+{
+	const __m256i gatherIndices = GetGatherIndices(packedStride);
+	const __m256i lowBits = _mm256_set1_epi32(0xFFFF);
+
+	alignas(32) float unpackedU[8];
+	alignas(32) float unpackedV[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const int* block = reinterpret_cast<const int*>(Offset(packed, i * packedStride));
+		__m256i uv = _mm256_i32gather_epi32(block, gatherIndices, 4);
+
+		// Packing works within 128 bit lanes: u0-3 v0-3 | u4-7 v4-7, the permute puts the us in the low half
+		__m256i halves = _mm256_packus_epi32(_mm256_and_si256(uv, lowBits), _mm256_srli_epi32(uv, 16));
+		halves = _mm256_permute4x64_epi64(halves, _MM_SHUFFLE(3, 1, 2, 0));
+
+		_mm256_store_ps(unpackedU, _mm256_cvtph_ps(_mm256_castsi256_si128(halves)));
+		_mm256_store_ps(unpackedV, _mm256_cvtph_ps(_mm256_extracti128_si256(halves, 1)));
+
+		for (int k = 0; k < 8; ++k)
+			*Offset(texCoords, (i + k) * texCoordStride) = XMFLOAT2(unpackedU[k], unpackedV[k]);
+	}
+
+	if (i < count)
+		UnpackTexCoordsScalar(Offset(packed, i * packedStride), packedStride, count - i, Offset(texCoords, i * texCoordStride), texCoordStride);
+}
+#endif
+
+static bool HasAVX2()
+{
+	static const bool hasAVX2 = CpuFeatures::Get().AVX2;
+	return hasAVX2;
+}
+
+static bool HasAVX2F16C()
+{
+	static const bool hasAVX2F16C = CpuFeatures::Get().AVX2 && CpuFeatures::Get().F16C;
+	return hasAVX2F16C;
+}
+
+static PackPositionsFn GetPackPositionsFn()
+{
+#if CPU_X86
+	if (HasAVX2())
+		return &PackPositionsAVX2;
+#endif
+
+	return &PackPositionsScalar;
+}
+
+static UnpackPositionsFn GetUnpackPositionsFn()
+{
+#if CPU_X86
+	if (HasAVX2())
+		return &UnpackPositionsAVX2;
+#endif
+
+	return &UnpackPositionsScalar;
+}
+
+static PackUnitVectorsFn GetPackUnitVectorsFn()
+{
+#if CPU_X86
+	if (HasAVX2())
+		return &PackUnitVectorsAVX2;
+#endif
+
+	return &PackUnitVectorsScalar;
+}
+
+static UnpackUnitVectorsFn GetUnpackUnitVectorsFn()
+{
+#if CPU_X86
+	if (HasAVX2())
+		return &UnpackUnitVectorsAVX2;
+#endif
+
+	return &UnpackUnitVectorsScalar;
+}
+
+static PackTexCoordsFn GetPackTexCoordsFn()
+{
+#if CPU_X86
+	if (HasAVX2F16C())
+		return &PackTexCoordsAVX2;
+#endif
+
+	return &PackTexCoordsScalar;
+}
+
+static UnpackTexCoordsFn GetUnpackTexCoordsFn()
+{
+#if CPU_X86
+	if (HasAVX2F16C())
+		return &UnpackTexCoordsAVX2;
+#endif
+
+	return &UnpackTexCoordsScalar;
+}
+
+static const PackPositionsFn s_PackPositions = GetPackPositionsFn();
+static const UnpackPositionsFn s_UnpackPositions = GetUnpackPositionsFn();
+static const PackUnitVectorsFn s_PackUnitVectors = GetPackUnitVectorsFn();
+static const UnpackUnitVectorsFn s_UnpackUnitVectors = GetUnpackUnitVectorsFn();
+static const PackTexCoordsFn s_PackTexCoords = GetPackTexCoordsFn();
+static const UnpackTexCoordsFn s_UnpackTexCoords = GetUnpackTexCoordsFn();
+
+void PackPositions(const XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, int16_t* packed, size_t packedStride)
+{
+	s_PackPositions(positions, positionStride, count, quantization, packed, packedStride);
+}
+
+void UnpackPositions(const int16_t* packed, size_t packedStride, size_t count, const VertexQuantization& quantization, XMFLOAT3* positions, size_t positionStride)
+{
+	s_UnpackPositions(packed, packedStride, count, quantization, positions, positionStride);
+}
+
+void PackUnitVectors(const XMFLOAT3* vectors, size_t vectorStride, size_t count, int16_t* packed, size_t packedStride)
+{
+	s_PackUnitVectors(vectors, vectorStride, count, packed, packedStride);
+}
+
+void UnpackUnitVectors(const int16_t* packed, size_t packedStride, size_t count, XMFLOAT3* vectors, size_t vectorStride)
+{
+	s_UnpackUnitVectors(packed, packedStride, count, vectors, vectorStride);
+}
+
+void PackTexCoords(const XMFLOAT2* texCoords, size_t texCoordStride, size_t count, uint16_t* packed, size_t packedStride)
+{
+	s_PackTexCoords(texCoords, texCoordStride, count, packed, packedStride);
+}
+
+void UnpackTexCoords(const uint16_t* packed, size_t packedStride, size_t count, XMFLOAT2* texCoords, size_t texCoordStride)
+{
+	s_UnpackTexCoords(packed, packedStride, count, texCoords, texCoordStride);
+}
+
+float MeasurePositionError(const XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, const int16_t* packed, size_t packedStride)
+{
+	std::vector<XMFLOAT3> unpacked(count);
+	UnpackPositions(packed, packedStride, count, quantization, unpacked.data(), sizeof(XMFLOAT3));
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR difference = XMVectorSubtract(XMLoadFloat3(Offset(positions, i * positionStride)), XMLoadFloat3(&unpacked[i]));
+		maxError = std::max<float>(maxError, XMVectorGetX(XMVector3Length(difference)));
+	}
+
+	return maxError;
+}
+
+float MeasureUnitVectorError(const XMFLOAT3* vectors, size_t vectorStride, size_t count, const int16_t* packed, size_t packedStride)
+{
+	std::vector<XMFLOAT3> unpacked(count);
+	UnpackUnitVectors(packed, packedStride, count, unpacked.data(), sizeof(XMFLOAT3));
+
+	// The angle from the sine and the cosine, acos alone has no precision left for the small angles
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		XMVECTOR vector = XMLoadFloat3(Offset(vectors, i * vectorStride));
+		XMVECTOR unpackedVector = XMLoadFloat3(&unpacked[i]);
+
+		float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(vector, unpackedVector)));
+		float cosine = XMVectorGetX(XMVector3Dot(vector, unpackedVector));
+		if (sine == 0.0f && cosine == 0.0f)
+			continue;
+
+		maxError = std::max<float>(maxError, std::atan2(sine, cosine) * s_DegreesPerRadian);
+	}
+
+	return maxError;
+}
+
+float MeasureTexCoordError(const XMFLOAT2* texCoords, size_t texCoordStride, size_t count, const uint16_t* packed, size_t packedStride)
+{
+	std::vector<XMFLOAT2> unpacked(count);
+	UnpackTexCoords(packed, packedStride, count, unpacked.data(), sizeof(XMFLOAT2));
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const XMFLOAT2& texCoord = *Offset(texCoords, i * texCoordStride);
+
+		maxError = std::max<float>(maxError, std::fabs(texCoord.x - unpacked[i].x));
+		maxError = std::max<float>(maxError, std::fabs(texCoord.y - unpacked[i].y));
+	}
+
+	return maxError;
+}
+
+std::vector<PackedVertex> PackVertices(const std::vector<GeometryGenerator::Vertex>& vertices, const VertexQuantization& quantization)
+{
+	std::vector<PackedVertex> packedVertices(vertices.size());
+	if (vertices.empty())
+		return packedVertices;
+
+	const size_t stride = sizeof(GeometryGenerator::Vertex);
+	const size_t packedStride = sizeof(PackedVertex);
+
+	PackPositions(&vertices[0].Position, stride, vertices.size(), quantization, packedVertices[0].Position, packedStride);
+	PackUnitVectors(&vertices[0].Normal, stride, vertices.size(), packedVertices[0].Normal, packedStride);
+	PackUnitVectors(&vertices[0].TangentU, stride, vertices.size(), packedVertices[0].TangentU, packedStride);
+	PackTexCoords(&vertices[0].TexC, stride, vertices.size(), packedVertices[0].TexC, packedStride);
+
+	return packedVertices;
+}
+
+std::vector<GeometryGenerator::Vertex> UnpackVertices(const std::vector<PackedVertex>& packedVertices, const VertexQuantization& quantization)
+{
+	std::vector<GeometryGenerator::Vertex> vertices(packedVertices.size());
+	if (packedVertices.empty())
+		return vertices;
+
+	const size_t stride = sizeof(GeometryGenerator::Vertex);
+	const size_t packedStride = sizeof(PackedVertex);
+
+	UnpackPositions(packedVertices[0].Position, packedStride, vertices.size(), quantization, &vertices[0].Position, stride);
+	UnpackUnitVectors(packedVertices[0].Normal, packedStride, vertices.size(), &vertices[0].Normal, stride);
+	UnpackUnitVectors(packedVertices[0].TangentU, packedStride, vertices.size(), &vertices[0].TangentU, stride);
+	UnpackTexCoords(packedVertices[0].TexC, packedStride, vertices.size(), &vertices[0].TexC, stride);
+
+	return vertices;
+}
+
+VertexPackingError MeasurePackingError(const std::vector<GeometryGenerator::Vertex>& vertices, const std::vector<PackedVertex>& packedVertices, const VertexQuantization& quantization)
+{
+	assert(vertices.size() == packedVertices.size());
+
+	VertexPackingError error;
+	if (vertices.empty())
+		return error;
+
+	const size_t stride = sizeof(GeometryGenerator::Vertex);
+	const size_t packedStride = sizeof(PackedVertex);
+
+	error.Position = MeasurePositionError(&vertices[0].Position, stride, vertices.size(), quantization, packedVertices[0].Position, packedStride);
+	error.Normal = MeasureUnitVectorError(&vertices[0].Normal, stride, vertices.size(), packedVertices[0].Normal, packedStride);
+	error.TangentU = MeasureUnitVectorError(&vertices[0].TangentU, stride, vertices.size(), packedVertices[0].TangentU, packedStride);
+	error.TexC = MeasureTexCoordError(&vertices[0].TexC, stride, vertices.size(), packedVertices[0].TexC, packedStride);
+
+	return error;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "GeometryGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+// Compressed vertex attributes, for static meshes that don't need full floats:
+// - positions are 16 bit snorms in the bounds of the mesh (DXGI_FORMAT_R16G16B16A16_SNORM, w is 0),
+//   the dequantize transform goes in front of the world matrix
+// - normals and tangents are folded onto an octahedron and stored as 2 16 bit snorms (DXGI_FORMAT_R16G16_SNORM),
+//   the shader unfolds them like UnpackUnitVectors
+// - texture coordinates are fp16 (DXGI_FORMAT_R16G16_FLOAT)
+// The streams are strided, so they pack from and into interleaved vertices. Strides have to be multiples of 4 bytes.
+// The AVX2 kernels give the same bits as the scalar ones.
+
+// Maps the positions of a mesh to [-1, 1]: packed = (position - Center) / Extent
+struct VertexQuantization
+{
+	DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 Extent = { 1.0f, 1.0f, 1.0f };
+
+	// Takes unpacked snorm positions back to the space of the mesh, to multiply in front of the world matrix
+	DirectX::XMFLOAT4X4 GetDequantizeTransform() const;
+};
+
+// The bounds of the positions. With uniformScale the extent is the same on every axis, then the dequantize
+// transform is a uniform scale and normals still go through the world matrix it is folded into.
+VertexQuantization ComputeVertexQuantization(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t count, bool uniformScale);
+
+void PackPositions(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, int16_t* packed, size_t packedStride);
+void UnpackPositions(const int16_t* packed, size_t packedStride, size_t count, const VertexQuantization& quantization, DirectX::XMFLOAT3* positions, size_t positionStride);
+
+// Octahedral encoding of unit vectors, the packed vectors are within 0.005 degrees of the originals
+void PackUnitVectors(const DirectX::XMFLOAT3* vectors, size_t vectorStride, size_t count, int16_t* packed, size_t packedStride);
+void UnpackUnitVectors(const int16_t* packed, size_t packedStride, size_t count, DirectX::XMFLOAT3* vectors, size_t vectorStride);
+
+void PackTexCoords(const DirectX::XMFLOAT2* texCoords, size_t texCoordStride, size_t count, uint16_t* packed, size_t packedStride);
+void UnpackTexCoords(const uint16_t* packed, size_t packedStride, size_t count, DirectX::XMFLOAT2* texCoords, size_t texCoordStride);
+
+// Largest distance between the positions and their packed ones, in the units of the positions
+float MeasurePositionError(const DirectX::XMFLOAT3* positions, size_t positionStride, size_t count, const VertexQuantization& quantization, const int16_t* packed, size_t packedStride);
+
+// Largest angle between the vectors and their packed ones, in degrees
+float MeasureUnitVectorError(const DirectX::XMFLOAT3* vectors, size_t vectorStride, size_t count, const int16_t* packed, size_t packedStride);
+
+// Largest difference of a texture coordinate and its packed one
+float MeasureTexCoordError(const DirectX::XMFLOAT2* texCoords, size_t texCoordStride, size_t count, const uint16_t* packed, size_t packedStride);
+
+// GeometryGenerator::Vertex in 20 bytes instead of 44
+struct PackedVertex
+{
+	int16_t Position[4];
+	int16_t Normal[2];
+	int16_t TangentU[2];
+	uint16_t TexC[2];
+};
+
+struct VertexPackingError
+{
+	float Position = 0.0f;
+	float Normal = 0.0f;		// Degrees
+	float TangentU = 0.0f;		// Degrees
+	float TexC = 0.0f;
+};
+
+std::vector<PackedVertex> PackVertices(const std::vector<GeometryGenerator::Vertex>& vertices, const VertexQuantization& quantization);
+std::vector<GeometryGenerator::Vertex> UnpackVertices(const std::vector<PackedVertex>& packedVertices, const VertexQuantization& quantization);
+
+VertexPackingError MeasurePackingError(const std::vector<GeometryGenerator::Vertex>& vertices, const std::vector<PackedVertex>& packedVertices, const VertexQuantization& quantization);
@@ -0,0 +1,85 @@
+#include "WaterSimulationManager.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float GetMillisecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+WaterSimulationManager::WaterSimulationManager()
+{
+
+}
+
+WaterSimulationManager::~WaterSimulationManager()
+{
+
+}
+
+int WaterSimulationManager::GetBodyCount() const
+{
+	return (int)m_Bodies.size();
+}
+
+WaterSurface& WaterSimulationManager::GetBody(int index)
+{
+	return *m_Bodies[index].Surface;
+}
+
+const WaterSurface& WaterSimulationManager::GetBody(int index) const
+{
+	return *m_Bodies[index].Surface;
+}
+
+void WaterSimulationManager::Update(float dTime)
+{
+	Clock::time_point updateStart = Clock::now();
+
+	// The cost of a step scales with the grid points that are simulated
+	// (e.g. only the active tiles of a tiled wave solver, as of the last step).
+	for (Body& body : m_Bodies)
+		body.Stats.SimulatedCellCount = body.Surface->GetSimulatedCellCount();
+
+	m_Schedule.resize(m_Bodies.size());
+	for (int i = 0; i < (int)m_Schedule.size(); ++i)
+		m_Schedule[i] = i;
+
+	std::stable_sort(m_Schedule.begin(), m_Schedule.end(), [this](int a, int b)
+	{
+		return m_Bodies[a].Stats.SimulatedCellCount > m_Bodies[b].Stats.SimulatedCellCount;
+	});
+
+	// Tasks grab the next body in the schedule as soon as they are done with one
+	TaskScheduler::Get().ParallelFor(0, (int)m_Schedule.size(), 1,
+		[this, dTime](int scheduleBegin, int scheduleEnd)
+	{
+		for (int i = scheduleBegin; i < scheduleEnd; ++i)
+		{
+			Body& body = m_Bodies[m_Schedule[i]];
+			Clock::time_point bodyStart = Clock::now();
+
+			body.Update(*body.Surface, dTime, body.Output);
+
+			body.Stats.StepCount = body.Surface->GetLastUpdateStepCount();
+			body.Stats.UpdateMilliseconds = GetMillisecondsSince(bodyStart);
+			body.Output = nullptr;
+		}
+	});
+
+	m_UpdateMilliseconds = GetMillisecondsSince(updateStart);
+}
+
+const WaterBodyStats& WaterSimulationManager::GetStats(int index) const
+{
+	return m_Bodies[index].Stats;
+}
+
+float WaterSimulationManager::GetUpdateMilliseconds() const
+{
+	return m_UpdateMilliseconds;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "WaterSurface.h"
+
+#include <cassert>
+#include <memory>
+#include <typeinfo>
+#include <vector>
+
+// Statistics of a body from the last WaterSimulationManager::Update
+struct WaterBodyStats
+{
+	int CellCount = 0;				// Grid points of the body
+	int SimulatedCellCount = 0;		// Grid points the batch expected to simulate per step (only the active tiles in tiled mode)
+	int StepCount = 0;				// Time steps the body took
+	// Wall time of the body's update, vertex output included. While the body waits for its own parallel work
+	// the thread helps out with other tasks of the batch, which can add to this time.
+	float UpdateMilliseconds = 0.0f;
+};
+
+// Owns the water bodies of a scene (lakes, pools, oceans, ...) and updates all of them as one parallel batch per frame.
+// Every body is a task of the batch and its own step is parallel too, so idle workers steal the bands of the big bodies
+// while the small ones finish. The bodies are queued biggest first (by simulated cells),
+// so the batch doesn't end with one big body running while the other cores have nothing left to do.
+class WaterSimulationManager
+{
+public:
+	WaterSimulationManager();
+	WaterSimulationManager(const WaterSimulationManager& other) = delete;
+	WaterSimulationManager& operator=(const WaterSimulationManager& other) = delete;
+	~WaterSimulationManager();
+
+	// Takes ownership of a body and returns its index. The body is an engine (WaveEngine, OceanEngine) with
+	// a Vertex type and an Update(float dTime, Vertex* vertices).
+	template<typename TEngine>
+	int AddBody(std::unique_ptr<TEngine> body);
+
+	int GetBodyCount() const;
+	WaterSurface& GetBody(int index);
+	const WaterSurface& GetBody(int index) const;
+
+	// Returns a body as the engine it was added as.
+	template<typename TEngine>
+	TEngine& GetEngine(int index);
+
+	// Sets where the next Update writes the vertices of a body to (e.g. the mapped vertex buffer of the current frame).
+	// The output is reset after every Update, bodies without one only advance their simulation.
+	template<typename TVertex>
+	void SetVertexOutput(int index, TVertex* vertices);
+
+	// Advances every body by dTime, see WaterSurface::Update.
+	void Update(float dTime);
+
+	const WaterBodyStats& GetStats(int index) const;
+
+	// Returns the wall time of the last Update
+	float GetUpdateMilliseconds() const;
+
+private:
+	// Updates surface as the engine it was added as and writes its vertices to output (if any).
+	typedef void(*UpdateBodyFn)(WaterSurface& surface, float dTime, void* output);
+
+	template<typename TEngine>
+	static void UpdateEngine(WaterSurface& surface, float dTime, void* output);
+
+	struct Body
+	{
+		std::unique_ptr<WaterSurface> Surface;
+		UpdateBodyFn Update = nullptr;
+		const std::type_info* VertexType = nullptr;
+		void* Output = nullptr;
+		WaterBodyStats Stats;
+	};
+
+private:
+	std::vector<Body> m_Bodies;
+
+	// Body indices in the order they are queued
+	std::vector<int> m_Schedule;
+
+	float m_UpdateMilliseconds = 0.0f;
+};
+
+template<typename TEngine>
+int WaterSimulationManager::AddBody(std::unique_ptr<TEngine> body)
+{
+	assert(body);
+
+	Body entry;
+	entry.Surface = std::move(body);
+	entry.Update = &UpdateEngine<TEngine>;
+	entry.VertexType = &typeid(typename TEngine::Vertex);
+	entry.Stats.CellCount = entry.Surface->GetVertexCount();
+
+	m_Bodies.push_back(std::move(entry));
+	return (int)m_Bodies.size() - 1;
+}
+
+template<typename TEngine>
+TEngine& WaterSimulationManager::GetEngine(int index)
+{
+	// Only bodies added as this engine have its update function
+	assert(m_Bodies[index].Update == &UpdateEngine<TEngine>);
+	return static_cast<TEngine&>(*m_Bodies[index].Surface);
+}
+
+template<typename TVertex>
+void WaterSimulationManager::SetVertexOutput(int index, TVertex* vertices)
+{
+	assert(*m_Bodies[index].VertexType == typeid(TVertex));
+	m_Bodies[index].Output = vertices;
+}
+
+template<typename TEngine>
+void WaterSimulationManager::UpdateEngine(WaterSurface& surface, float dTime, void* output)
+{
+	static_cast<TEngine&>(surface).Update(dTime, static_cast<typename TEngine::Vertex*>(output));
+}
@@ -0,0 +1,53 @@
+#include "WaterSurface.h"
+
+WaterSurface::WaterSurface(int numRows, int numColumns, float spatialStep):
+	m_NumRows(numRows),
+	m_NumColumns(numColumns),
+	m_VertexCount(numRows*numColumns),
+	m_TriangleCount((numRows - 1)*(numColumns - 1) * 2),
+	m_SpatialStep(spatialStep),
+	m_HalfWidth((numColumns - 1) * spatialStep * 0.5f),
+	m_HalfDepth((numRows - 1) * spatialStep * 0.5f)
+{
+
+}
+
+WaterSurface::~WaterSurface()
+{
+
+}
+
+int WaterSurface::GetRowCount() const
+{
+	return m_NumRows;
+}
+
+int WaterSurface::GetColumnCount() const
+{
+	return m_NumColumns;
+}
+
+int WaterSurface::GetVertexCount() const
+{
+	return m_VertexCount;
+}
+
+int WaterSurface::GetTriangleCount() const
+{
+	return m_TriangleCount;
+}
+
+float WaterSurface::GetWidth() const
+{
+	return m_NumColumns * m_SpatialStep;
+}
+
+float WaterSurface::GetDepth() const
+{
+	return m_NumRows * m_SpatialStep;
+}
+
+int WaterSurface::GetSimulatedCellCount() const
+{
+	return m_VertexCount;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "HeightField.h"
+
+#include <DirectXMath.h>
+
+// Interface of the water models (WaveSolver, OceanSolver): a surface sampled on a grid of rows x columns points
+// over the xz-plane, centered at the origin. Row 0 is at the +z edge and column 0 at the -x edge,
+// neighbouring grid points are the spatial step apart.
+class WaterSurface
+{
+public:
+	WaterSurface(int numRows, int numColumns, float spatialStep);
+	WaterSurface(const WaterSurface& other) = delete;
+	WaterSurface& operator=(const WaterSurface& other) = delete;
+	virtual ~WaterSurface();
+
+	int GetRowCount() const;
+	int GetColumnCount() const;
+	int GetVertexCount() const;
+	int GetTriangleCount() const;
+	float GetWidth() const;
+	float GetDepth() const;
+
+	// Returns the position of the grid point at index
+	virtual DirectX::XMFLOAT3 GetPosition(int idx) const = 0;
+
+	// Returns the height of the grid point at index
+	virtual float GetHeight(int idx) const = 0;
+
+	// Returns a view of the heights for SampleHeightField, valid until the next update
+	virtual HeightFieldView GetHeightField() const = 0;
+
+	// Advances the surface dTime seconds
+	virtual void Update(float dTime) = 0;
+
+	// Returns how many time steps the last Update took
+	virtual int GetLastUpdateStepCount() const = 0;
+
+	// Returns roughly how many grid points an Update works on per step, to balance the work of several surfaces
+	virtual int GetSimulatedCellCount() const;
+
+protected:
+	int m_NumRows;
+	int m_NumColumns;
+
+	int m_VertexCount;
+	int m_TriangleCount;
+
+	float m_SpatialStep;
+
+	float m_HalfWidth;
+	float m_HalfDepth;
+};
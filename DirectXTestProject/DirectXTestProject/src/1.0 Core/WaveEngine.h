@@ -0,0 +1,322 @@
+#pragma once
+
+#include "WaveSolver.h"
+#include "TaskScheduler.h"
+#include "HalfFloat.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include <DirectXMath.h>
+
+// Describes which attributes WaveEngine computes and emits for a vertex layout.
+// Specialise it next to every vertex type the engine outputs:
+//
+//	template<>
+//	struct WaveVertexTraits<MyVertex>
+//	{
+//		static const bool HasNormal = true;		// Stores and computes a normal per grid point
+//		static const bool HasTangent = false;	// Stores and computes a tangent in the local x-axis direction per grid point
+//		static const bool HasColor = false;		// Colors the vertices with GetColor
+//
+//		static DirectX::XMFLOAT4 GetColor(float height);
+//		static void Write(MyVertex& vertex, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT3& tangent, const DirectX::XMFLOAT4& color);
+//	};
+//
+// The flags are compile time constants: attributes a layout doesn't use are neither stored nor computed,
+// Write gets the attribute of a flat grid (or black for the color) for them and is free to ignore it.
+template<typename TVertex>
+struct WaveVertexTraits;
+
+// A float3 attribute per grid point, packed as 3 fp16 values when the solver runs in Float16 precision.
+class WaveAttributeArray
+{
+public:
+	void Assign(int count, const DirectX::XMFLOAT3& value)
+	{
+		m_Values.assign(count, value);
+		m_PackedValues.clear();
+	}
+
+	// Converts the attributes between the float3 and fp16 storage
+	void SetPacked(bool packed)
+	{
+		if (packed == this->IsPacked())
+			return;
+
+		if (packed)
+		{
+			m_PackedValues.resize(3 * m_Values.size());
+			FloatToHalf(&m_Values[0].x, m_PackedValues.data(), (int)m_PackedValues.size());
+			std::vector<DirectX::XMFLOAT3>().swap(m_Values);
+		}
+		else
+		{
+			m_Values.resize(m_PackedValues.size() / 3);
+			HalfToFloat(m_PackedValues.data(), &m_Values[0].x, (int)m_PackedValues.size());
+			std::vector<uint16_t>().swap(m_PackedValues);
+		}
+	}
+
+	bool IsPacked() const
+	{
+		return !m_PackedValues.empty();
+	}
+
+	DirectX::XMFLOAT3 Load(int idx) const
+	{
+		if (!this->IsPacked())
+			return m_Values[idx];
+
+		const uint16_t* packed = &m_PackedValues[3 * idx];
+		return DirectX::XMFLOAT3(HalfToFloat(packed[0]), HalfToFloat(packed[1]), HalfToFloat(packed[2]));
+	}
+
+	void Store(int idx, const DirectX::XMFLOAT3& value)
+	{
+		if (!this->IsPacked())
+		{
+			m_Values[idx] = value;
+			return;
+		}
+
+		uint16_t* packed = &m_PackedValues[3 * idx];
+		packed[0] = FloatToHalf(value.x);
+		packed[1] = FloatToHalf(value.y);
+		packed[2] = FloatToHalf(value.z);
+	}
+
+	void Fill(int begin, int end, const DirectX::XMFLOAT3& value)
+	{
+		for (int idx = begin; idx < end; ++idx)
+			this->Store(idx, value);
+	}
+
+private:
+	std::vector<DirectX::XMFLOAT3> m_Values;
+	std::vector<uint16_t> m_PackedValues;
+};
+
+// Wave simulation that outputs its solution as vertices of type TVertex.
+template<typename TVertex>
+class WaveEngine : public WaveSolver
+{
+public:
+	using Vertex = TVertex;
+	using Traits = WaveVertexTraits<TVertex>;
+
+	WaveEngine(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping);
+	WaveEngine(const WaveEngine& other) = delete;
+	WaveEngine& operator=(const WaveEngine& other) = delete;
+	~WaveEngine();
+
+	// Returns the solution normal of the grid at index. The attributes have to be up to date (see UpdateAttributes).
+	DirectX::XMFLOAT3 GetNormal(int idx) const;
+
+	// Returns the unit tangent vector of the grid at index in the local x-axis direction, like GetNormal
+	DirectX::XMFLOAT3 GetTangentX(int idx) const;
+
+	using WaveSolver::Update;
+
+	// Same as Update, but also writes the vertices of the solution straight into vertices
+	// (GetVertexCount() of them, e.g. the mapped vertex buffer of the current frame).
+	// When the simulation steps, the vertices are written by the normal pass while the rows are still in cache.
+	// Without vertices only the heights are advanced.
+	void Update(float dTime, TVertex* vertices);
+
+	// Writes the vertices of the current solution into vertices, or only those of the rows [rowBegin, rowEnd)
+	// (e.g. of the patches that are visible). Only the attributes of those rows are brought up to date.
+	void WriteVertices(TVertex* vertices);
+	void WriteVertices(TVertex* vertices, int rowBegin, int rowEnd);
+
+protected:
+	void ComputeAttributesRow(const float* up, const float* curr, const float* down, int row, int columnBegin, int columnEnd) override;
+	void ResetAttributesRow(int row, int columnBegin, int columnEnd) override;
+	void EmitRow(const float* heights, int row) override;
+	void OnPrecisionChanged() override;
+
+private:
+	// Writes the vertices of one row, position from the given heights (indexed by column) and the current attributes.
+	void WriteVerticesRow(TVertex* vertices, const float* heights, int row) const;
+
+private:
+	// Only allocated when the vertex layout has them
+	WaveAttributeArray m_Normals;
+	WaveAttributeArray m_TangentX;
+
+	// Where the fused normal pass writes the vertices to, only set during Update
+	TVertex* m_OutputVertices = nullptr;
+};
+
+template<typename TVertex>
+WaveEngine<TVertex>::WaveEngine(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping):
+	WaveSolver(numRows, numColumns, spatialStep, timeStep, speed, damping)
+{
+	if (Traits::HasNormal)
+		m_Normals.Assign(numRows * numColumns, DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+	if (Traits::HasTangent)
+		m_TangentX.Assign(numRows * numColumns, DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f));
+}
+
+template<typename TVertex>
+WaveEngine<TVertex>::~WaveEngine()
+{
+
+}
+
+template<typename TVertex>
+DirectX::XMFLOAT3 WaveEngine<TVertex>::GetNormal(int idx) const
+{
+	static_assert(Traits::HasNormal, "The vertex layout of this wave engine has no normals");
+	assert(this->AreAttributesCurrent(idx / m_NumColumns, idx / m_NumColumns + 1));
+
+	return m_Normals.Load(idx);
+}
+
+template<typename TVertex>
+DirectX::XMFLOAT3 WaveEngine<TVertex>::GetTangentX(int idx) const
+{
+	static_assert(Traits::HasTangent, "The vertex layout of this wave engine has no tangents");
+	assert(this->AreAttributesCurrent(idx / m_NumColumns, idx / m_NumColumns + 1));
+
+	return m_TangentX.Load(idx);
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::Update(float dTime, TVertex* vertices)
+{
+	int stepCount = this->AccumulateTime(dTime);
+
+	if (!vertices)
+	{
+		this->Step(stepCount);
+		return;
+	}
+
+	m_OutputVertices = vertices;
+	this->StepAndEmit(stepCount);
+	m_OutputVertices = nullptr;
+
+	// Only the dense normal pass writes the vertices on the fly, sleeping tiles aren't visited
+	// and every frame resource has its own buffer, so it needs the vertices even without a step.
+	if (stepCount == 0 || this->IsTiledMode())
+		this->WriteVertices(vertices);
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::WriteVertices(TVertex* vertices)
+{
+	this->WriteVertices(vertices, 0, m_NumRows);
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::WriteVertices(TVertex* vertices, int rowBegin, int rowEnd)
+{
+	assert(rowBegin >= 0 && rowEnd <= m_NumRows);
+
+	this->UpdateAttributes(rowBegin, rowEnd);
+
+	int rowsPerChunk = std::max<int>(1, 4096 / m_NumColumns);
+
+	TaskScheduler::Get().ParallelFor(rowBegin, rowEnd, rowsPerChunk,
+		[this, vertices](int rowBegin, int rowEnd)
+	{
+		std::vector<float> scratch(m_NumColumns);
+
+		for (int row = rowBegin; row < rowEnd; ++row)
+			this->WriteVerticesRow(vertices, this->GetCurrentHeightsRow(row, scratch.data()), row);
+	});
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::ComputeAttributesRow(const float* up, const float* curr, const float* down, int row, int columnBegin, int columnEnd)
+{
+	if (!Traits::HasNormal && !Traits::HasTangent)
+		return;
+
+	//
+	// Compute normals using finite difference scheme.
+	//
+	int rowOffset = row * m_NumColumns;
+
+	for (int column = columnBegin; column < columnEnd; ++column)
+	{
+		float l = curr[column - 1];
+		float r = curr[column + 1];
+		float t = up[column];
+		float b = down[column];
+
+		if (Traits::HasNormal)
+		{
+			DirectX::XMFLOAT3 normal(-r + l, 2.0f * m_SpatialStep, b - t);
+			DirectX::XMStoreFloat3(&normal, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&normal)));
+			m_Normals.Store(rowOffset + column, normal);
+		}
+
+		if (Traits::HasTangent)
+		{
+			DirectX::XMFLOAT3 tangent(2.0f * m_SpatialStep, r - l, 0.0f);
+			DirectX::XMStoreFloat3(&tangent, DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&tangent)));
+			m_TangentX.Store(rowOffset + column, tangent);
+		}
+	}
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::ResetAttributesRow(int row, int columnBegin, int columnEnd)
+{
+	int rowOffset = row * m_NumColumns;
+
+	if (Traits::HasNormal)
+		m_Normals.Fill(rowOffset + columnBegin, rowOffset + columnEnd, DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f));
+
+	if (Traits::HasTangent)
+		m_TangentX.Fill(rowOffset + columnBegin, rowOffset + columnEnd, DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f));
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::EmitRow(const float* heights, int row)
+{
+	if (m_OutputVertices)
+		this->WriteVerticesRow(m_OutputVertices, heights, row);
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::OnPrecisionChanged()
+{
+	bool packed = this->GetPrecision() == WavePrecision::Float16;
+
+	if (Traits::HasNormal)
+		m_Normals.SetPacked(packed);
+
+	if (Traits::HasTangent)
+		m_TangentX.SetPacked(packed);
+}
+
+template<typename TVertex>
+void WaveEngine<TVertex>::WriteVerticesRow(TVertex* vertices, const float* heights, int row) const
+{
+	const DirectX::XMFLOAT3 flatNormal(0.0f, 1.0f, 0.0f);
+	const DirectX::XMFLOAT3 flatTangent(1.0f, 0.0f, 0.0f);
+	const DirectX::XMFLOAT4 black(0.0f, 0.0f, 0.0f, 1.0f);
+
+	// Whole vertices are written in order, the destination usually is write-combined upload memory
+	int rowOffset = row * m_NumColumns;
+	float z = m_HalfDepth - row * m_SpatialStep;
+
+	for (int column = 0; column < m_NumColumns; ++column)
+	{
+		int idx = rowOffset + column;
+		float height = heights[column];
+
+		TVertex vertex;
+		Traits::Write(vertex,
+			DirectX::XMFLOAT3(-m_HalfWidth + column * m_SpatialStep, height, z),
+			Traits::HasNormal ? m_Normals.Load(idx) : flatNormal,
+			Traits::HasTangent ? m_TangentX.Load(idx) : flatTangent,
+			Traits::HasColor ? Traits::GetColor(height) : black);
+
+		vertices[idx] = vertex;
+	}
+}
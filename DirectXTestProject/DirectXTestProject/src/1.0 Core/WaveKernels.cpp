@@ -0,0 +1,263 @@
+#include "WaveKernels.h"
+#include "CpuFeatures.h"
+#include "HalfFloat.h"
+
+#include <atomic>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+#include "ExactFloatingPoint.h"
+
+// Every kernel evaluates the stencil in exactly the same order as the scalar code:
+// ((k1 * prev + k2 * curr) + k3 * (((down + up) + right) + left))
+
+typedef void(*WaveStepRowFn)(float*, const float*, const float*, const float*, int, int, float, float, float);
+typedef void(*WaveStepRowHalfFn)(uint16_t*, const uint16_t*, const uint16_t*, const uint16_t*, int, int, float, float, float);
+
+void WaveStepRowScalar(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	for (int column = columnBegin; column < columnEnd; ++column)
+	{
+		prev[column] =
+			k1 * prev[column] +
+			k2 * curr[column] +
+			k3 * (down[column] +
+				up[column] +
+				curr[column + 1] +
+				curr[column - 1]);
+	}
+}
+
+static void WaveStepRowHalfScalar(uint16_t* prev, const uint16_t* up, const uint16_t* curr, const uint16_t* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	for (int column = columnBegin; column < columnEnd; ++column)
+	{
+		float result =
+			k1 * HalfToFloat(prev[column]) +
+			k2 * HalfToFloat(curr[column]) +
+			k3 * (HalfToFloat(down[column]) +
+				HalfToFloat(up[column]) +
+				HalfToFloat(curr[column + 1]) +
+				HalfToFloat(curr[column - 1]));
+
+		prev[column] = FloatToHalf(result);
+	}
+}
+
+#if CPU_X86
+static void WaveStepRowSSE(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	const __m128 vk1 = _mm_set1_ps(k1);
+	const __m128 vk2 = _mm_set1_ps(k2);
+	const __m128 vk3 = _mm_set1_ps(k3);
+
+	int column = columnBegin;
+	for (; column + 4 <= columnEnd; column += 4)
+	{
+		__m128 neighbours = _mm_add_ps(_mm_loadu_ps(down + column), _mm_loadu_ps(up + column));
+		neighbours = _mm_add_ps(neighbours, _mm_loadu_ps(curr + column + 1));
+		neighbours = _mm_add_ps(neighbours, _mm_loadu_ps(curr + column - 1));
+
+		__m128 result = _mm_add_ps(_mm_mul_ps(vk1, _mm_loadu_ps(prev + column)), _mm_mul_ps(vk2, _mm_loadu_ps(curr + column)));
+		result = _mm_add_ps(result, _mm_mul_ps(vk3, neighbours));
+
+		_mm_storeu_ps(prev + column, result);
+	}
+
+	WaveStepRowScalar(prev, up, curr, down, column, columnEnd, k1, k2, k3);
+}
+
+CPU_TARGET("avx2")
+static void WaveStepRowAVX2(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	const __m256 vk1 = _mm256_set1_ps(k1);
+	const __m256 vk2 = _mm256_set1_ps(k2);
+	const __m256 vk3 = _mm256_set1_ps(k3);
+
+	int column = columnBegin;
+	for (; column + 8 <= columnEnd; column += 8)
+	{
+		__m256 neighbours = _mm256_add_ps(_mm256_loadu_ps(down + column), _mm256_loadu_ps(up + column));
+		neighbours = _mm256_add_ps(neighbours, _mm256_loadu_ps(curr + column + 1));
+		neighbours = _mm256_add_ps(neighbours, _mm256_loadu_ps(curr + column - 1));
+
+		__m256 result = _mm256_add_ps(_mm256_mul_ps(vk1, _mm256_loadu_ps(prev + column)), _mm256_mul_ps(vk2, _mm256_loadu_ps(curr + column)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(vk3, neighbours));
+
+		_mm256_storeu_ps(prev + column, result);
+	}
+
+	// Let the 4 wide kernel handle the tail before going scalar.
+	WaveStepRowSSE(prev, up, curr, down, column, columnEnd, k1, k2, k3);
+}
+
+CPU_TARGET("avx512f")
+static void WaveStepRowAVX512(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	const __m512 vk1 = _mm512_set1_ps(k1);
+	const __m512 vk2 = _mm512_set1_ps(k2);
+	const __m512 vk3 = _mm512_set1_ps(k3);
+
+	int column = columnBegin;
+	for (; column + 16 <= columnEnd; column += 16)
+	{
+		__m512 neighbours = _mm512_add_ps(_mm512_loadu_ps(down + column), _mm512_loadu_ps(up + column));
+		neighbours = _mm512_add_ps(neighbours, _mm512_loadu_ps(curr + column + 1));
+		neighbours = _mm512_add_ps(neighbours, _mm512_loadu_ps(curr + column - 1));
+
+		__m512 result = _mm512_add_ps(_mm512_mul_ps(vk1, _mm512_loadu_ps(prev + column)), _mm512_mul_ps(vk2, _mm512_loadu_ps(curr + column)));
+		result = _mm512_add_ps(result, _mm512_mul_ps(vk3, neighbours));
+
+		_mm512_storeu_ps(prev + column, result);
+	}
+
+	// Use a masked store for the tail, so short rows don't fall back to narrower kernels.
+	int remaining = columnEnd - column;
+	if (remaining > 0)
+	{
+		__mmask16 mask = (__mmask16)((1u << remaining) - 1);
+
+		__m512 neighbours = _mm512_add_ps(_mm512_maskz_loadu_ps(mask, down + column), _mm512_maskz_loadu_ps(mask, up + column));
+		neighbours = _mm512_add_ps(neighbours, _mm512_maskz_loadu_ps(mask, curr + column + 1));
+		neighbours = _mm512_add_ps(neighbours, _mm512_maskz_loadu_ps(mask, curr + column - 1));
+
+		__m512 result = _mm512_add_ps(_mm512_mul_ps(vk1, _mm512_maskz_loadu_ps(mask, prev + column)), _mm512_mul_ps(vk2, _mm512_maskz_loadu_ps(mask, curr + column)));
+		result = _mm512_add_ps(result, _mm512_mul_ps(vk3, neighbours));
+
+		_mm512_mask_storeu_ps(prev + column, mask, result);
+	}
+}
+
+CPU_TARGET("avx,f16c")
+static __m256 LoadHalf8(const uint16_t* source)
+{
+	return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)source));
+}
+
+CPU_TARGET("avx,f16c")
+static void WaveStepRowHalfF16C(uint16_t* prev, const uint16_t* up, const uint16_t* curr, const uint16_t* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	const __m256 vk1 = _mm256_set1_ps(k1);
+	const __m256 vk2 = _mm256_set1_ps(k2);
+	const __m256 vk3 = _mm256_set1_ps(k3);
+
+	int column = columnBegin;
+	for (; column + 8 <= columnEnd; column += 8)
+	{
+		__m256 neighbours = _mm256_add_ps(LoadHalf8(down + column), LoadHalf8(up + column));
+		neighbours = _mm256_add_ps(neighbours, LoadHalf8(curr + column + 1));
+		neighbours = _mm256_add_ps(neighbours, LoadHalf8(curr + column - 1));
+
+		__m256 result = _mm256_add_ps(_mm256_mul_ps(vk1, LoadHalf8(prev + column)), _mm256_mul_ps(vk2, LoadHalf8(curr + column)));
+		result = _mm256_add_ps(result, _mm256_mul_ps(vk3, neighbours));
+
+		_mm_storeu_si128((__m128i*)(prev + column), _mm256_cvtps_ph(result, _MM_FROUND_TO_NEAREST_INT));
+	}
+
+	WaveStepRowHalfScalar(prev, up, curr, down, column, columnEnd, k1, k2, k3);
+}
+#endif
+
+static bool IsWaveKernelSupported(WaveKernel kernel)
+{
+	const CpuFeatures& features = CpuFeatures::Get();
+
+	switch (kernel)
+	{
+	case WaveKernel::Scalar:	return true;
+#if CPU_X86
+	case WaveKernel::SSE:		return true; // SSE2 is part of x64
+	case WaveKernel::AVX2:		return features.AVX2;
+	case WaveKernel::AVX512:	return features.AVX512F;
+#endif
+	default:					return false;
+	}
+}
+
+static WaveStepRowFn GetWaveStepRowFn(WaveKernel kernel)
+{
+	switch (kernel)
+	{
+#if CPU_X86
+	case WaveKernel::SSE:		return &WaveStepRowSSE;
+	case WaveKernel::AVX2:		return &WaveStepRowAVX2;
+	case WaveKernel::AVX512:	return &WaveStepRowAVX512;
+#endif
+	default:					return &WaveStepRowScalar;
+	}
+}
+
+WaveKernel GetBestWaveKernel()
+{
+	for (int kernel = (int)WaveKernel::Count - 1; kernel > 0; --kernel)
+	{
+		if (IsWaveKernelSupported((WaveKernel)kernel))
+			return (WaveKernel)kernel;
+	}
+
+	return WaveKernel::Scalar;
+}
+
+// F16C comes with every AVX2 CPU, the fp16 kernel follows the float one: only forcing Scalar disables it.
+static WaveStepRowHalfFn GetWaveStepRowHalfFn(WaveKernel kernel)
+{
+#if CPU_X86
+	const CpuFeatures& features = CpuFeatures::Get();
+	if (kernel != WaveKernel::Scalar && features.AVX && features.F16C)
+		return &WaveStepRowHalfF16C;
+#endif
+
+	(void)kernel;
+	return &WaveStepRowHalfScalar;
+}
+
+static std::atomic<WaveKernel> s_WaveKernel(GetBestWaveKernel());
+static std::atomic<WaveStepRowFn> s_WaveStepRow(GetWaveStepRowFn(s_WaveKernel));
+static std::atomic<WaveStepRowHalfFn> s_WaveStepRowHalf(GetWaveStepRowHalfFn(s_WaveKernel));
+
+WaveKernel GetWaveKernel()
+{
+	return s_WaveKernel;
+}
+
+void SetWaveKernel(WaveKernel kernel)
+{
+	if (!IsWaveKernelSupported(kernel))
+		kernel = GetBestWaveKernel();
+
+	s_WaveKernel = kernel;
+	s_WaveStepRow = GetWaveStepRowFn(kernel);
+	s_WaveStepRowHalf = GetWaveStepRowHalfFn(kernel);
+}
+
+const char* GetWaveKernelName(WaveKernel kernel)
+{
+	switch (kernel)
+	{
+	case WaveKernel::Scalar:	return "Scalar";
+	case WaveKernel::SSE:		return "SSE";
+	case WaveKernel::AVX2:		return "AVX2";
+	case WaveKernel::AVX512:	return "AVX-512";
+	default:					return "Unknown";
+	}
+}
+
+void WaveStepRow(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	s_WaveStepRow.load(std::memory_order_relaxed)(prev, up, curr, down, columnBegin, columnEnd, k1, k2, k3);
+}
+
+void WaveStepRowHalf(uint16_t* prev, const uint16_t* up, const uint16_t* curr, const uint16_t* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3)
+{
+	s_WaveStepRowHalf.load(std::memory_order_relaxed)(prev, up, curr, down, columnBegin, columnEnd, k1, k2, k3);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// SIMD kernels for the finite difference wave equation used by the wave simulations.
+// The kernels work on height planes (one float per grid point, row major),
+// the simulation calls them once per row.
+
+enum class WaveKernel : char
+{
+	Scalar = 0,
+	SSE,	// 4 columns per instruction
+	AVX2,	// 8 columns per instruction
+	AVX512,	// 16 columns per instruction
+
+	Count
+};
+
+// Returns the widest kernel the CPU we are running on supports.
+WaveKernel GetBestWaveKernel();
+
+// Returns the kernel WaveStepRow currently dispatches to.
+WaveKernel GetWaveKernel();
+
+// Overrides the kernel WaveStepRow dispatches to.
+// All kernels produce bit-for-bit the same result as the scalar one,
+// so forcing Scalar is only needed to validate or to profile the SIMD kernels.
+// Requesting a kernel the CPU doesn't support falls back to the best supported one.
+void SetWaveKernel(WaveKernel kernel);
+
+const char* GetWaveKernelName(WaveKernel kernel);
+
+// Advances the columns [columnBegin, columnEnd) of one row a single time step:
+// prev[c] = k1 * prev[c] + k2 * curr[c] + k3 * (down[c] + up[c] + curr[c + 1] + curr[c - 1])
+// "up" and "down" are the rows above and below "curr" in the current solution.
+// The new solution is written over the previous one.
+void WaveStepRow(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3);
+
+// Scalar reference of WaveStepRow, regardless of the selected kernel.
+void WaveStepRowScalar(float* prev, const float* up, const float* curr, const float* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3);
+
+// Same as WaveStepRow, but on fp16 height planes: the heights are converted to float,
+// stepped exactly like WaveStepRowScalar does and rounded back to nearest even.
+// Uses F16C when the CPU has it, which gives the same bits as the scalar conversion.
+void WaveStepRowHalf(uint16_t* prev, const uint16_t* up, const uint16_t* curr, const uint16_t* down,
+	int columnBegin, int columnEnd, float k1, float k2, float k3);
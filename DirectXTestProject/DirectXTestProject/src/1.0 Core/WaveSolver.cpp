@@ -0,0 +1,1226 @@
+#include "WaveSolver.h"
+#include "WaveKernels.h"
+#include "HalfFloat.h"
+#include "TaskScheduler.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <cassert>
+
+using namespace DirectX;
+
+// A snapshot file is the header, the tiles (in tiled mode) and then the previous and the current solution,
+// each solution starting at a page boundary so it can be simulated on right where it is mapped.
+struct WaveSnapshotHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t HeaderSize;
+	int32_t NumRows;
+	int32_t NumColumns;
+	float SpatialStep;
+	float TimeStep;
+	float K1;
+	float K2;
+	float K3;
+	float AccumulatedTime;
+	float SleepEpsilon;
+	int32_t MaxSubSteps;
+	int32_t TileCount;
+	uint8_t Precision;
+	uint8_t TiledMode;
+	uint8_t Reserved[6];
+	uint64_t TilesOffset;
+	uint64_t PlaneSize;
+	uint64_t PrevHeightsOffset;
+	uint64_t CurrentHeightsOffset;
+};
+
+struct WaveSnapshotTile
+{
+	uint32_t Active;
+	float Amplitude;
+	float PreviousAmplitude;
+	float EdgeAmplitude[4];
+};
+
+static_assert(sizeof(WaveSnapshotHeader) == 96, "The snapshot header has no padding");
+
+static const char s_SnapshotMagic[4] = { 'W', 'A', 'V', 'S' };
+static const uint32_t s_SnapshotVersion = 1;
+static const uint64_t s_SnapshotAlignment = 4096;
+
+static uint64_t AlignSnapshotOffset(uint64_t offset)
+{
+	return (offset + s_SnapshotAlignment - 1) & ~(s_SnapshotAlignment - 1);
+}
+
+WaveSolver::WaveSolver(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping):
+	WaterSurface(numRows, numColumns, spatialStep),
+	m_TimeStep(timeStep)
+{
+	float d = damping * timeStep + 2.0f;
+	float e = (speed * speed)*(timeStep*timeStep) / (spatialStep*spatialStep);
+
+	m_K1 = (damping*timeStep - 2.0f) / d;
+	m_K2 = (4.0f - 8.0f * e) / d;
+	m_K3 = (2.0f * e) / d;
+
+	// Heights start out flat, x and z are derived from the grid point's row/column
+	m_PrevHeights.Assign(numRows * numColumns, 0.0f);
+	m_CurrentHeights.Assign(numRows * numColumns, 0.0f);
+
+	// The attributes of a flat grid are the initial ones of the derived class
+	m_AttributeBandsCurrent.assign((numRows - 2 + s_TileSize - 1) / s_TileSize, 1);
+}
+
+WaveSolver::~WaveSolver()
+{
+
+}
+
+DirectX::XMFLOAT3 WaveSolver::GetPosition(int idx) const
+{
+	int row = idx / m_NumColumns;
+	int column = idx - row * m_NumColumns;
+
+	return XMFLOAT3(-m_HalfWidth + column * m_SpatialStep, this->LoadHeight(false, idx), m_HalfDepth - row * m_SpatialStep);
+}
+
+float WaveSolver::GetHeight(int idx) const
+{
+	return this->LoadHeight(false, idx);
+}
+
+void WaveSolver::Update(float dTime)
+{
+	this->Step(this->AccumulateTime(dTime));
+}
+
+int WaveSolver::AccumulateTime(float dTime)
+{
+	// Accumulate time
+	m_AccumulatedTime += dTime;
+
+	// Only update the simulation in steps of the specified time step,
+	// running as many steps as the elapsed time asks for.
+	int stepCount = static_cast<int>(m_AccumulatedTime / m_TimeStep);
+	m_AccumulatedTime -= stepCount * m_TimeStep;
+
+	// If we fell too far behind (e.g. after a hitch), drop the steps we can't catch up on
+	// instead of taking longer and longer every frame.
+	m_LastUpdateStepCount = std::min<int>(stepCount, m_MaxSubSteps);
+
+	return m_LastUpdateStepCount;
+}
+
+void WaveSolver::SetMaxSubSteps(int maxSubSteps)
+{
+	assert(maxSubSteps > 0);
+	m_MaxSubSteps = maxSubSteps;
+}
+
+int WaveSolver::GetMaxSubSteps() const
+{
+	return m_MaxSubSteps;
+}
+
+int WaveSolver::GetLastUpdateStepCount() const
+{
+	return m_LastUpdateStepCount;
+}
+
+int WaveSolver::GetSimulatedCellCount() const
+{
+	if (!m_TiledMode || m_Tiles.empty())
+		return m_VertexCount;
+
+	return (int)((long long)m_VertexCount * this->GetActiveTileCount() / this->GetTileCount());
+}
+
+float WaveSolver::GetInterpolationAlpha() const
+{
+	return std::min<float>(m_AccumulatedTime / m_TimeStep, 1.0f);
+}
+
+float WaveSolver::GetPreviousHeight(int idx) const
+{
+	return this->LoadHeight(true, idx);
+}
+
+HeightFieldView WaveSolver::GetHeightField() const
+{
+	HeightFieldView view;
+	view.NumRows = m_NumRows;
+	view.NumColumns = m_NumColumns;
+	view.OriginX = -m_HalfWidth;
+	view.OriginZ = m_HalfDepth;
+	view.CellSizeX = m_SpatialStep;
+	view.CellSizeZ = m_SpatialStep;
+
+	if (this->UsesHalfPrecision())
+	{
+		view.Heights = m_CurrentHeightsHalf.GetData();
+		view.Format = HeightFieldFormat::Float16;
+	}
+	else
+	{
+		view.Heights = m_CurrentHeights.GetData();
+	}
+
+	return view;
+}
+
+const float* WaveSolver::GetCurrentHeightsRow(int row, float* scratch) const
+{
+	return this->LoadRow(false, row, 0, m_NumColumns, scratch);
+}
+
+void WaveSolver::Step(int stepCount)
+{
+	this->Advance(stepCount, false);
+}
+
+void WaveSolver::StepAndEmit(int stepCount)
+{
+	this->Advance(stepCount, true);
+}
+
+void WaveSolver::Advance(int stepCount, bool emit)
+{
+	assert(stepCount >= 0);
+
+	if (stepCount <= 0)
+		return;
+
+	this->ApplyDisturbances();
+
+	if (m_TiledMode)
+	{
+		for (int step = 0; step < stepCount; ++step)
+			this->StepTiled();
+
+		this->InvalidateAttributes(0, m_NumRows);
+		if (emit)
+			this->UpdateAttributes();
+	}
+	else
+	{
+		// When emitting, only the last step needs the attributes,
+		// all steps before that just advance the heights.
+		int remainingSteps = emit ? stepCount - 1 : stepCount;
+		while (remainingSteps > 0)
+		{
+			int blockedSteps = std::min<int>(remainingSteps, s_MaxBlockedSteps);
+			this->StepBlocked(blockedSteps);
+
+			remainingSteps -= blockedSteps;
+		}
+
+		this->InvalidateAttributes(0, m_NumRows);
+		if (emit)
+			this->StepFused();
+	}
+
+	if (m_Validate && this->UsesHalfPrecision())
+		this->StepValidation(stepCount);
+}
+
+void WaveSolver::UpdateAttributes()
+{
+	this->UpdateAttributes(0, m_NumRows);
+}
+
+void WaveSolver::UpdateAttributes(int rowBegin, int rowEnd)
+{
+	// Most calls find their bands up to date, those don't need a parallel for
+	if (this->AreAttributesCurrent(rowBegin, rowEnd))
+		return;
+
+	int bandBegin, bandEnd;
+	this->GetAttributeBands(rowBegin, rowEnd, bandBegin, bandEnd);
+
+	TaskScheduler::Get().ParallelFor(bandBegin, bandEnd, 1,
+		[this](int chunkBegin, int chunkEnd)
+	{
+		std::vector<float> scratch(3 * m_NumColumns);
+
+		for (int band = chunkBegin; band < chunkEnd; ++band)
+		{
+			if (m_AttributeBandsCurrent[band])
+				continue;
+
+			this->ComputeBandAttributes(band, scratch.data());
+			m_AttributeBandsCurrent[band] = 1;
+		}
+	});
+}
+
+bool WaveSolver::AreAttributesCurrent(int rowBegin, int rowEnd) const
+{
+	int bandBegin, bandEnd;
+	this->GetAttributeBands(rowBegin, rowEnd, bandBegin, bandEnd);
+
+	auto isCurrent = [](char current) { return current != 0; };
+	return std::all_of(m_AttributeBandsCurrent.begin() + bandBegin, m_AttributeBandsCurrent.begin() + bandEnd, isCurrent);
+}
+
+void WaveSolver::StepFused()
+{
+	// The grid is split in bands of rows that are processed by one task each.
+	// Within a band the attributes (normals, vertices, ...) trail the height update by one row:
+	// as soon as the row below has its new heights, a row can be finished while
+	// its heights are still in L1/L2, instead of sweeping the whole grid a second time.
+	// Only the first and last row of a band depend on rows another task is working on,
+	// those are patched up after all bands are done.
+	int rowsPerBand = this->GetRowsPerBand();
+
+	// After this update we will be discarding the old previous
+	// buffer, so overwrite that buffer with the new update.
+	// Until the swap at the end, the previous solution holds the new one.
+	int bandCount = (m_NumRows - 3) / rowsPerBand + 1;
+
+	TaskScheduler::Get().ParallelFor(0, bandCount, 1,
+		[this, rowsPerBand](int bandBegin, int bandEnd)
+	{
+		// In Float16 precision FinishRow converts the rows it needs into this
+		std::vector<float> scratch(3 * m_NumColumns);
+
+		for (int band = bandBegin; band < bandEnd; ++band)
+		{
+			int rowBegin = 1 + band * rowsPerBand;
+			int rowEnd = std::min<int>(rowBegin + rowsPerBand, m_NumRows - 1);
+
+			// The fixed boundary rows never change, so they count as done
+			bool aboveBandDone = rowBegin == 1;
+			bool belowBandDone = rowEnd == m_NumRows - 1;
+
+			for (int row = rowBegin; row < rowEnd; ++row)
+			{
+				// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
+				// Moreover, our +z axis goes "down"; this is just to 
+				// keep consistent with our row indices going down.
+				this->StepRow(true, row, 1, m_NumColumns - 1);
+
+				int normalRow = row - 1;
+				if (normalRow > rowBegin || (normalRow == rowBegin && aboveBandDone))
+					this->FinishRow(normalRow, scratch.data());
+			}
+
+			int lastRow = rowEnd - 1;
+			if (belowBandDone && (lastRow > rowBegin || aboveBandDone))
+				this->FinishRow(lastRow, scratch.data());
+		}
+	});
+
+	// Patch up the band edges that were skipped above.
+	TaskScheduler::Get().ParallelFor(0, bandCount, 64,
+		[this, rowsPerBand](int bandBegin, int bandEnd)
+	{
+		std::vector<float> scratch(3 * m_NumColumns);
+
+		for (int band = bandBegin; band < bandEnd; ++band)
+		{
+			int rowBegin = 1 + band * rowsPerBand;
+			int rowEnd = std::min<int>(rowBegin + rowsPerBand, m_NumRows - 1);
+
+			bool patchFirstRow = rowBegin != 1;
+			if (patchFirstRow)
+				this->FinishRow(rowBegin, scratch.data());
+
+			int lastRow = rowEnd - 1;
+			if (rowEnd != m_NumRows - 1 && !(patchFirstRow && lastRow == rowBegin))
+				this->FinishRow(lastRow, scratch.data());
+		}
+	});
+
+	// The boundary rows never change, but every frame resource needs them
+	std::vector<float> scratch(m_NumColumns);
+	this->EmitRow(this->LoadRow(true, 0, 0, m_NumColumns, scratch.data()), 0);
+	this->EmitRow(this->LoadRow(true, m_NumRows - 1, 0, m_NumColumns, scratch.data()), m_NumRows - 1);
+
+	// We just overwrote the previous buffer with the new data, so
+	// this data needs to become the current solution and the old
+	// current solution becomes the new previous solution.
+	this->SwapSolutions();
+
+	std::fill(m_AttributeBandsCurrent.begin(), m_AttributeBandsCurrent.end(), 1);
+}
+
+void WaveSolver::StepBlocked(int stepCount)
+{
+	// The leapfrog scheme only needs the two solution buffers: step k overwrites the
+	// buffer holding step k - 2, so odd steps write the previous and even steps the current buffer.
+	auto stepRows = [this](int step, int rowBegin, int rowEnd)
+	{
+		for (int row = rowBegin; row < rowEnd; ++row)
+			this->StepRow((step & 1) != 0, row, 1, m_NumColumns - 1);
+	};
+
+	// Bands need to be at least 2 * stepCount rows tall so the triangles of phase 2 don't overlap.
+	// The last band takes the remaining rows.
+	int rowsPerBand = std::max<int>(this->GetRowsPerBand(), 2 * stepCount);
+	int bandCount = std::max<int>((m_NumRows - 2) / rowsPerBand, 1);
+
+	auto getBandBegin = [rowsPerBand](int band) { return 1 + band * rowsPerBand; };
+	auto getBandEnd = [this, rowsPerBand, bandCount](int band) { return band == bandCount - 1 ? m_NumRows - 1 : 1 + (band + 1) * rowsPerBand; };
+
+	// Phase 1: every band advances all steps on its own while it is in cache.
+	// A row next to another band depends on rows that band hasn't computed yet,
+	// so every step covers one row less on the sides that border another band (a trapezoid in space-time).
+	// The fixed boundary rows never change, so bands don't shrink on those sides.
+	TaskScheduler::Get().ParallelFor(0, bandCount, 1,
+		[&](int bandBegin, int bandEnd)
+	{
+		for (int band = bandBegin; band < bandEnd; ++band)
+		{
+			int rowBegin = getBandBegin(band);
+			int rowEnd = getBandEnd(band);
+
+			for (int step = 1; step <= stepCount; ++step)
+			{
+				int shrink = step - 1;
+				stepRows(step,
+					rowBegin == 1 ? rowBegin : rowBegin + shrink,
+					rowEnd == m_NumRows - 1 ? rowEnd : rowEnd - shrink);
+			}
+		}
+	});
+
+	// Phase 2: fill in the upside down triangles around the band boundaries phase 1 left out.
+	// All their inputs are in place now, and phase 1 didn't overwrite any of them:
+	// the rows bordering a triangle are exactly the ones phase 1 stopped at.
+	TaskScheduler::Get().ParallelFor(1, bandCount, 1,
+		[&](int bandBegin, int bandEnd)
+	{
+		for (int band = bandBegin; band < bandEnd; ++band)
+		{
+			int boundary = getBandBegin(band);
+
+			for (int step = 2; step <= stepCount; ++step)
+				stepRows(step, boundary - (step - 1), boundary + (step - 1));
+		}
+	});
+
+	// After an odd number of steps the newest solution is in the previous buffer.
+	if (stepCount & 1)
+		this->SwapSolutions();
+}
+
+void WaveSolver::SetTiledMode(bool tiled)
+{
+	if (tiled == m_TiledMode)
+		return;
+
+	m_TiledMode = tiled;
+	m_Tiles.clear();
+	m_ActiveTiles.clear();
+
+	if (!tiled)
+		return;
+
+	// Tiles cover the interior grid points, the boundary stays fixed at 0
+	m_TileRowCount = (m_NumRows - 2 + s_TileSize - 1) / s_TileSize;
+	m_TileColumnCount = (m_NumColumns - 2 + s_TileSize - 1) / s_TileSize;
+	m_Tiles.resize(m_TileRowCount * m_TileColumnCount);
+
+	for (int tileRow = 0; tileRow < m_TileRowCount; ++tileRow)
+	{
+		for (int tileColumn = 0; tileColumn < m_TileColumnCount; ++tileColumn)
+		{
+			Tile& tile = m_Tiles[tileRow * m_TileColumnCount + tileColumn];
+			tile.RowBegin = 1 + tileRow * s_TileSize;
+			tile.RowEnd = std::min<int>(tile.RowBegin + s_TileSize, m_NumRows - 1);
+			tile.ColumnBegin = 1 + tileColumn * s_TileSize;
+			tile.ColumnEnd = std::min<int>(tile.ColumnBegin + s_TileSize, m_NumColumns - 1);
+		}
+	}
+
+	// We don't know where the waves are yet, start out with every tile awake
+	// and let the quiet ones fall asleep after their first steps.
+	for (int i = 0; i < (int)m_Tiles.size(); ++i)
+		this->WakeTile(i);
+}
+
+bool WaveSolver::IsTiledMode() const
+{
+	return m_TiledMode;
+}
+
+void WaveSolver::SetSleepEpsilon(float epsilon)
+{
+	assert(epsilon >= 0.0f);
+	m_SleepEpsilon = epsilon;
+}
+
+int WaveSolver::GetTileCount() const
+{
+	return (int)m_Tiles.size();
+}
+
+int WaveSolver::GetActiveTileCount() const
+{
+	int activeTileCount = 0;
+	for (const Tile& tile : m_Tiles)
+		activeTileCount += tile.Active ? 1 : 0;
+
+	return activeTileCount;
+}
+
+void WaveSolver::StepTiled()
+{
+	m_ActiveTiles.clear();
+	for (int i = 0; i < (int)m_Tiles.size(); ++i)
+	{
+		if (m_Tiles[i].Active)
+			m_ActiveTiles.push_back(i);
+	}
+
+	// Sleeping tiles are flat in both solutions, so swapping the buffers leaves them flat.
+	// Active tiles only read the neighbouring tiles' current solution and only write their own
+	// part of the previous one, so they can all be stepped in parallel.
+	TaskScheduler::Get().ParallelFor(0, (int)m_ActiveTiles.size(), 1,
+		[this](int tileBegin, int tileEnd)
+	{
+		std::vector<float> scratch(m_NumColumns);
+
+		for (int i = tileBegin; i < tileEnd; ++i)
+		{
+			Tile& tile = m_Tiles[m_ActiveTiles[i]];
+
+			float amplitude = 0.0f;
+			float leftAmplitude = 0.0f;
+			float rightAmplitude = 0.0f;
+
+			for (int row = tile.RowBegin; row < tile.RowEnd; ++row)
+			{
+				this->StepRow(true, row, tile.ColumnBegin, tile.ColumnEnd);
+
+				// Measure the new row while it is still in cache
+				const float* prev = this->LoadRow(true, row, tile.ColumnBegin, tile.ColumnEnd, scratch.data());
+
+				float rowAmplitude = 0.0f;
+				for (int column = tile.ColumnBegin; column < tile.ColumnEnd; ++column)
+					rowAmplitude = std::max<float>(rowAmplitude, std::abs(prev[column]));
+
+				amplitude = std::max<float>(amplitude, rowAmplitude);
+				leftAmplitude = std::max<float>(leftAmplitude, std::abs(prev[tile.ColumnBegin]));
+				rightAmplitude = std::max<float>(rightAmplitude, std::abs(prev[tile.ColumnEnd - 1]));
+
+				if (row == tile.RowBegin)
+					tile.EdgeAmplitude[0] = rowAmplitude;
+				if (row == tile.RowEnd - 1)
+					tile.EdgeAmplitude[1] = rowAmplitude;
+			}
+
+			tile.EdgeAmplitude[2] = leftAmplitude;
+			tile.EdgeAmplitude[3] = rightAmplitude;
+			tile.PreviousAmplitude = tile.Amplitude;
+			tile.Amplitude = amplitude;
+		}
+	});
+
+	this->SwapSolutions();
+
+	// Put the tiles that have calmed down to sleep first, so a tile that is
+	// both calm and reached by a neighbour's wavefront stays awake.
+	for (int tileIndex : m_ActiveTiles)
+	{
+		const Tile& tile = m_Tiles[tileIndex];
+		if (tile.Amplitude < m_SleepEpsilon && tile.PreviousAmplitude < m_SleepEpsilon)
+			this->SleepTile(tileIndex);
+	}
+
+	// Wake up the neighbours of tiles with a wavefront at their edge.
+	// The stencil only reaches the direct neighbours, diagonal tiles are woken a step later through them.
+	for (int tileIndex : m_ActiveTiles)
+	{
+		const Tile& tile = m_Tiles[tileIndex];
+		int tileRow = tileIndex / m_TileColumnCount;
+		int tileColumn = tileIndex - tileRow * m_TileColumnCount;
+
+		if (tile.EdgeAmplitude[0] >= m_SleepEpsilon && tileRow > 0)
+			this->WakeTile(tileIndex - m_TileColumnCount);
+		if (tile.EdgeAmplitude[1] >= m_SleepEpsilon && tileRow < m_TileRowCount - 1)
+			this->WakeTile(tileIndex + m_TileColumnCount);
+		if (tile.EdgeAmplitude[2] >= m_SleepEpsilon && tileColumn > 0)
+			this->WakeTile(tileIndex - 1);
+		if (tile.EdgeAmplitude[3] >= m_SleepEpsilon && tileColumn < m_TileColumnCount - 1)
+			this->WakeTile(tileIndex + 1);
+	}
+}
+
+void WaveSolver::ComputeBandAttributes(int band, float* scratch)
+{
+	int rowBegin = 1 + band * s_TileSize;
+	int rowEnd = std::min<int>(rowBegin + s_TileSize, m_NumRows - 1);
+
+	if (!m_TiledMode)
+	{
+		for (int row = rowBegin; row < rowEnd; ++row)
+		{
+			const float* up = this->LoadRow(false, row - 1, 0, m_NumColumns, scratch);
+			const float* curr = this->LoadRow(false, row, 0, m_NumColumns, scratch + m_NumColumns);
+			const float* down = this->LoadRow(false, row + 1, 0, m_NumColumns, scratch + 2 * m_NumColumns);
+
+			this->ComputeAttributesRow(up, curr, down, row, 1, m_NumColumns - 1);
+		}
+
+		return;
+	}
+
+	// A band is a row of tiles.
+	// Grid points of sleeping tiles next to an active tile keep their flat attributes,
+	// the active tile's edge is below the sleep epsilon or the neighbour would have been woken up.
+	for (int tileColumn = 0; tileColumn < m_TileColumnCount; ++tileColumn)
+	{
+		const Tile& tile = m_Tiles[band * m_TileColumnCount + tileColumn];
+		if (!tile.Active)
+			continue;
+
+		for (int row = tile.RowBegin; row < tile.RowEnd; ++row)
+		{
+			const float* up = this->LoadRow(false, row - 1, tile.ColumnBegin, tile.ColumnEnd, scratch);
+			const float* curr = this->LoadRow(false, row, tile.ColumnBegin - 1, tile.ColumnEnd + 1, scratch + m_NumColumns);
+			const float* down = this->LoadRow(false, row + 1, tile.ColumnBegin, tile.ColumnEnd, scratch + 2 * m_NumColumns);
+
+			this->ComputeAttributesRow(up, curr, down, row, tile.ColumnBegin, tile.ColumnEnd);
+		}
+	}
+}
+
+void WaveSolver::InvalidateAttributes(int rowBegin, int rowEnd)
+{
+	int bandBegin, bandEnd;
+	this->GetAttributeBands(rowBegin, rowEnd, bandBegin, bandEnd);
+
+	std::fill(m_AttributeBandsCurrent.begin() + bandBegin, m_AttributeBandsCurrent.begin() + bandEnd, 0);
+}
+
+void WaveSolver::GetAttributeBands(int rowBegin, int rowEnd, int& bandBegin, int& bandEnd) const
+{
+	// Only interior rows have computed attributes, the boundary rows stay flat
+	rowBegin = std::max<int>(rowBegin, 1);
+	rowEnd = std::min<int>(rowEnd, m_NumRows - 1);
+
+	bandBegin = (rowBegin - 1) / s_TileSize;
+	bandEnd = rowBegin < rowEnd ? (rowEnd - 2) / s_TileSize + 1 : bandBegin;
+}
+void WaveSolver::WakeTile(int tileIndex)
+{
+	Tile& tile = m_Tiles[tileIndex];
+	if (tile.Active)
+		return;
+
+	// Keep the tile awake until it has measured both solutions itself
+	tile.Active = true;
+	tile.Amplitude = FLT_MAX;
+	tile.PreviousAmplitude = FLT_MAX;
+	for (float& edgeAmplitude : tile.EdgeAmplitude)
+		edgeAmplitude = 0.0f;
+}
+
+void WaveSolver::SleepTile(int tileIndex)
+{
+	Tile& tile = m_Tiles[tileIndex];
+	tile.Active = false;
+
+	// Flatten the tile, so its neighbours see exactly 0 and nothing drifts while it sleeps
+	for (int row = tile.RowBegin; row < tile.RowEnd; ++row)
+	{
+		this->ZeroRow(row, tile.ColumnBegin, tile.ColumnEnd);
+		this->ResetAttributesRow(row, tile.ColumnBegin, tile.ColumnEnd);
+	}
+}
+
+void WaveSolver::WakeTilesAround(int rowIndex, int columnIndex)
+{
+	// A disturbance touches the grid point and its direct neighbours, which can straddle a tile edge
+	int tileRowBegin = (rowIndex - 2) / s_TileSize;
+	int tileRowEnd = std::min<int>(rowIndex / s_TileSize, m_TileRowCount - 1);
+	int tileColumnBegin = (columnIndex - 2) / s_TileSize;
+	int tileColumnEnd = std::min<int>(columnIndex / s_TileSize, m_TileColumnCount - 1);
+
+	for (int tileRow = tileRowBegin; tileRow <= tileRowEnd; ++tileRow)
+	{
+		for (int tileColumn = tileColumnBegin; tileColumn <= tileColumnEnd; ++tileColumn)
+			this->WakeTile(tileRow * m_TileColumnCount + tileColumn);
+	}
+}
+
+void WaveSolver::FinishRow(int row, float* scratch)
+{
+	// The new solution is in the previous buffer until the swap
+	const float* up = this->LoadRow(true, row - 1, 0, m_NumColumns, scratch);
+	const float* curr = this->LoadRow(true, row, 0, m_NumColumns, scratch + m_NumColumns);
+	const float* down = this->LoadRow(true, row + 1, 0, m_NumColumns, scratch + 2 * m_NumColumns);
+
+	this->ComputeAttributesRow(up, curr, down, row, 1, m_NumColumns - 1);
+	this->EmitRow(curr, row);
+}
+
+int WaveSolver::GetRowsPerBand() const
+{
+	// Bands need to be tall enough that the two edge rows we patch up afterwards are
+	// only a small part of the work, and small enough that every thread gets a few of them.
+	// ~32K grid points keeps the rows a band is working on in L2.
+	int interiorRowCount = m_NumRows - 2;
+	int threadCount = TaskScheduler::Get().GetWorkerCount() + 1;
+
+	int rowsPerBand = std::max<int>(1, 32768 / m_NumColumns);
+	rowsPerBand = std::min<int>(rowsPerBand, interiorRowCount / (2 * threadCount));
+
+	return std::max<int>(rowsPerBand, 8);
+}
+
+void WaveSolver::Disturb(int rowIndex, int columnIndex, float magnitude)
+{
+	// Don't disturb boundaries
+	assert(rowIndex > 1 && rowIndex < m_NumRows - 2);
+	assert(columnIndex > 1 && columnIndex < m_NumColumns - 2);
+
+	if (m_TiledMode)
+		this->WakeTilesAround(rowIndex, columnIndex);
+
+	float halfMag = 0.5f * magnitude;
+
+	// The attributes of a row depend on the rows above and below it
+	this->InvalidateAttributes(rowIndex - 2, rowIndex + 3);
+
+	// Disturb the ijth vertex height and its neighbors
+	this->AddToCurrentHeight(rowIndex * m_NumColumns + columnIndex, magnitude);
+	this->AddToCurrentHeight(rowIndex * m_NumColumns + columnIndex + 1, halfMag);
+	this->AddToCurrentHeight(rowIndex * m_NumColumns + columnIndex - 1, halfMag);
+	this->AddToCurrentHeight((rowIndex + 1) * m_NumColumns + columnIndex, halfMag);
+	this->AddToCurrentHeight((rowIndex - 1) * m_NumColumns + columnIndex, halfMag);
+}
+
+void WaveSolver::Disturb(const WaveDisturbance* disturbances, int count)
+{
+	assert(count >= 0);
+	m_PendingDisturbances.insert(m_PendingDisturbances.end(), disturbances, disturbances + count);
+}
+
+void WaveSolver::ApplyDisturbances()
+{
+	if (m_PendingDisturbances.empty())
+		return;
+
+	// Splatting a disturbance scatters writes over a few rows, so instead of applying them one by one
+	// they are sorted in bands of s_TileSize rows (a counting sort, a disturbance goes in every band it touches).
+	// Every band is then applied by one task, touching only its own rows and tiles.
+	int bandCount = (m_NumRows - 2 + s_TileSize - 1) / s_TileSize;
+	float invSpatialStep = 1.0f / m_SpatialStep;
+
+	// Returns the interior rows [rowBegin, rowEnd) within the radius of a disturbance
+	auto getRowRange = [this, invSpatialStep](const WaveDisturbance& disturbance, int& rowBegin, int& rowEnd)
+	{
+		float row = (m_HalfDepth - disturbance.Z) * invSpatialStep;
+		float radius = std::max<float>(disturbance.Radius, m_SpatialStep) * invSpatialStep;
+		rowBegin = std::max<int>((int)std::ceil(row - radius), 1);
+		rowEnd = std::min<int>((int)std::floor(row + radius) + 1, m_NumRows - 1);
+	};
+
+	m_DisturbanceBandOffsets.assign(bandCount + 1, 0);
+	for (const WaveDisturbance& disturbance : m_PendingDisturbances)
+	{
+		int rowBegin, rowEnd;
+		getRowRange(disturbance, rowBegin, rowEnd);
+
+		for (int band = (rowBegin - 1) / s_TileSize; rowBegin < rowEnd && band <= (rowEnd - 2) / s_TileSize; ++band)
+			++m_DisturbanceBandOffsets[band + 1];
+	}
+
+	for (int band = 0; band < bandCount; ++band)
+		m_DisturbanceBandOffsets[band + 1] += m_DisturbanceBandOffsets[band];
+
+	m_SortedDisturbances.resize(m_DisturbanceBandOffsets[bandCount]);
+	std::vector<int> bandEnds(m_DisturbanceBandOffsets.begin(), m_DisturbanceBandOffsets.end() - 1);
+
+	for (int i = 0; i < (int)m_PendingDisturbances.size(); ++i)
+	{
+		int rowBegin, rowEnd;
+		getRowRange(m_PendingDisturbances[i], rowBegin, rowEnd);
+
+		for (int band = (rowBegin - 1) / s_TileSize; rowBegin < rowEnd && band <= (rowEnd - 2) / s_TileSize; ++band)
+			m_SortedDisturbances[bandEnds[band]++] = i;
+	}
+
+	TaskScheduler::Get().ParallelFor(0, bandCount, 1,
+		[&](int bandBegin, int bandEnd)
+	{
+		// The splat of a row, indexed by column
+		std::vector<float> splat(m_NumColumns);
+
+		for (int band = bandBegin; band < bandEnd; ++band)
+		{
+			int bandRowBegin = 1 + band * s_TileSize;
+			int bandRowEnd = std::min<int>(bandRowBegin + s_TileSize, m_NumRows - 1);
+
+			for (int i = m_DisturbanceBandOffsets[band]; i < m_DisturbanceBandOffsets[band + 1]; ++i)
+			{
+				const WaveDisturbance& disturbance = m_PendingDisturbances[m_SortedDisturbances[i]];
+
+				float row = (m_HalfDepth - disturbance.Z) * invSpatialStep;
+				float column = (disturbance.X + m_HalfWidth) * invSpatialStep;
+				float radius = std::max<float>(disturbance.Radius, m_SpatialStep) * invSpatialStep;
+				float invRadiusSq = 1.0f / (radius * radius);
+
+				int rowBegin = std::max<int>((int)std::ceil(row - radius), bandRowBegin);
+				int rowEnd = std::min<int>((int)std::floor(row + radius) + 1, bandRowEnd);
+				int columnBegin = std::max<int>((int)std::ceil(column - radius), 1);
+				int columnEnd = std::min<int>((int)std::floor(column + radius) + 1, m_NumColumns - 1);
+
+				if (columnBegin >= columnEnd)
+					continue;
+
+				for (int r = rowBegin; r < rowEnd; ++r)
+				{
+					float dz = r - row;
+
+					for (int c = columnBegin; c < columnEnd; ++c)
+					{
+						float dx = c - column;
+						float falloff = std::max<float>(1.0f - (dx * dx + dz * dz) * invRadiusSq, 0.0f);
+						splat[c] = disturbance.Magnitude * falloff * falloff;
+					}
+
+					this->AddToCurrentRow(r, columnBegin, columnEnd, splat.data());
+				}
+
+				// The tiles of this band are only touched by this task
+				if (m_TiledMode && rowBegin < rowEnd)
+				{
+					for (int tileColumn = (columnBegin - 1) / s_TileSize; tileColumn <= (columnEnd - 2) / s_TileSize; ++tileColumn)
+						this->WakeTile(band * m_TileColumnCount + tileColumn);
+				}
+			}
+		}
+	});
+
+	m_PendingDisturbances.clear();
+}
+
+void WaveSolver::SetPrecision(WavePrecision precision)
+{
+	if (precision == m_Precision)
+		return;
+
+	int vertexCount = m_NumRows * m_NumColumns;
+
+	if (precision == WavePrecision::Float16)
+	{
+		m_PrevHeightsHalf.Resize(vertexCount);
+		m_CurrentHeightsHalf.Resize(vertexCount);
+		FloatToHalf(m_PrevHeights.GetData(), m_PrevHeightsHalf.GetData(), vertexCount);
+		FloatToHalf(m_CurrentHeights.GetData(), m_CurrentHeightsHalf.GetData(), vertexCount);
+
+		// When validating, the float solutions carry on as the fp32 copy
+		if (!m_Validate)
+		{
+			m_PrevHeights.Release();
+			m_CurrentHeights.Release();
+		}
+	}
+	else
+	{
+		m_PrevHeights.Resize(vertexCount);
+		m_CurrentHeights.Resize(vertexCount);
+		HalfToFloat(m_PrevHeightsHalf.GetData(), m_PrevHeights.GetData(), vertexCount);
+		HalfToFloat(m_CurrentHeightsHalf.GetData(), m_CurrentHeights.GetData(), vertexCount);
+
+		m_PrevHeightsHalf.Release();
+		m_CurrentHeightsHalf.Release();
+	}
+
+	m_Precision = precision;
+	m_ValidationError = 0.0f;
+
+	this->OnPrecisionChanged();
+}
+
+WavePrecision WaveSolver::GetPrecision() const
+{
+	return m_Precision;
+}
+
+void WaveSolver::SetValidation(bool validate)
+{
+	if (validate == m_Validate)
+		return;
+
+	m_Validate = validate;
+	m_ValidationError = 0.0f;
+
+	// In Float32 precision there is nothing to compare against
+	if (!this->UsesHalfPrecision())
+		return;
+
+	int vertexCount = m_NumRows * m_NumColumns;
+
+	if (validate)
+	{
+		m_PrevHeights.Resize(vertexCount);
+		m_CurrentHeights.Resize(vertexCount);
+		HalfToFloat(m_PrevHeightsHalf.GetData(), m_PrevHeights.GetData(), vertexCount);
+		HalfToFloat(m_CurrentHeightsHalf.GetData(), m_CurrentHeights.GetData(), vertexCount);
+	}
+	else
+	{
+		m_PrevHeights.Release();
+		m_CurrentHeights.Release();
+	}
+}
+
+bool WaveSolver::IsValidating() const
+{
+	return m_Validate;
+}
+
+float WaveSolver::GetValidationError() const
+{
+	return m_ValidationError;
+}
+
+bool WaveSolver::SaveSnapshot(const std::wstring& fileName)
+{
+	// The solutions can still be in the mapping of the file that gets replaced, and a mapped file can't be replaced on Windows
+	if (fileName == m_SnapshotFileName)
+	{
+		m_PrevHeights.Detach();
+		m_CurrentHeights.Detach();
+		m_PrevHeightsHalf.Detach();
+		m_CurrentHeightsHalf.Detach();
+		m_SnapshotFileName.clear();
+	}
+
+	bool half = this->UsesHalfPrecision();
+
+	WaveSnapshotHeader header = {};
+	memcpy(header.Magic, s_SnapshotMagic, sizeof(header.Magic));
+	header.Version = s_SnapshotVersion;
+	header.HeaderSize = sizeof(WaveSnapshotHeader);
+	header.NumRows = m_NumRows;
+	header.NumColumns = m_NumColumns;
+	header.SpatialStep = m_SpatialStep;
+	header.TimeStep = m_TimeStep;
+	header.K1 = m_K1;
+	header.K2 = m_K2;
+	header.K3 = m_K3;
+	header.AccumulatedTime = m_AccumulatedTime;
+	header.SleepEpsilon = m_SleepEpsilon;
+	header.MaxSubSteps = m_MaxSubSteps;
+	header.TileCount = (int32_t)m_Tiles.size();
+	header.Precision = (uint8_t)m_Precision;
+	header.TiledMode = m_TiledMode ? 1 : 0;
+	header.TilesOffset = sizeof(WaveSnapshotHeader);
+	header.PlaneSize = (uint64_t)m_VertexCount * (half ? sizeof(uint16_t) : sizeof(float));
+	header.PrevHeightsOffset = AlignSnapshotOffset(header.TilesOffset + m_Tiles.size() * sizeof(WaveSnapshotTile));
+	header.CurrentHeightsOffset = AlignSnapshotOffset(header.PrevHeightsOffset + header.PlaneSize);
+
+	std::shared_ptr<MappedFile> file = MappedFile::Create(fileName, (size_t)(header.CurrentHeightsOffset + header.PlaneSize));
+	if (!file)
+		return false;
+
+	uint8_t* data = file->GetData();
+	memcpy(data, &header, sizeof(WaveSnapshotHeader));
+
+	WaveSnapshotTile* tiles = reinterpret_cast<WaveSnapshotTile*>(data + header.TilesOffset);
+	for (int i = 0; i < (int)m_Tiles.size(); ++i)
+	{
+		const Tile& tile = m_Tiles[i];
+		tiles[i].Active = tile.Active ? 1 : 0;
+		tiles[i].Amplitude = tile.Amplitude;
+		tiles[i].PreviousAmplitude = tile.PreviousAmplitude;
+		memcpy(tiles[i].EdgeAmplitude, tile.EdgeAmplitude, sizeof(tile.EdgeAmplitude));
+	}
+
+	if (half)
+	{
+		memcpy(data + header.PrevHeightsOffset, m_PrevHeightsHalf.GetData(), (size_t)header.PlaneSize);
+		memcpy(data + header.CurrentHeightsOffset, m_CurrentHeightsHalf.GetData(), (size_t)header.PlaneSize);
+	}
+	else
+	{
+		memcpy(data + header.PrevHeightsOffset, m_PrevHeights.GetData(), (size_t)header.PlaneSize);
+		memcpy(data + header.CurrentHeightsOffset, m_CurrentHeights.GetData(), (size_t)header.PlaneSize);
+	}
+
+	return file->Commit();
+}
+
+bool WaveSolver::RestoreSnapshot(const std::wstring& fileName)
+{
+	std::shared_ptr<MappedFile> file = MappedFile::Open(fileName);
+	if (!file || file->GetSize() < sizeof(WaveSnapshotHeader))
+		return false;
+
+	uint8_t* data = file->GetData();
+	uint64_t fileSize = file->GetSize();
+	const WaveSnapshotHeader& header = *reinterpret_cast<const WaveSnapshotHeader*>(data);
+
+	if (memcmp(header.Magic, s_SnapshotMagic, sizeof(header.Magic)) != 0 ||
+		header.Version != s_SnapshotVersion ||
+		header.HeaderSize != sizeof(WaveSnapshotHeader) ||
+		header.NumRows != m_NumRows || header.NumColumns != m_NumColumns ||
+		header.Precision > (uint8_t)WavePrecision::Float16)
+		return false;
+
+	WavePrecision precision = (WavePrecision)header.Precision;
+	bool half = precision == WavePrecision::Float16;
+	uint64_t planeSize = (uint64_t)m_VertexCount * (half ? sizeof(uint16_t) : sizeof(float));
+
+	int tileCount = 0;
+	if (header.TiledMode)
+		tileCount = ((m_NumRows - 2 + s_TileSize - 1) / s_TileSize) * ((m_NumColumns - 2 + s_TileSize - 1) / s_TileSize);
+
+	if (header.PlaneSize != planeSize || header.TileCount != tileCount ||
+		header.TilesOffset % alignof(WaveSnapshotTile) != 0 ||
+		header.PrevHeightsOffset % s_SnapshotAlignment != 0 || header.CurrentHeightsOffset % s_SnapshotAlignment != 0 ||
+		header.TilesOffset + tileCount * sizeof(WaveSnapshotTile) > fileSize ||
+		header.PrevHeightsOffset + planeSize > fileSize || header.CurrentHeightsOffset + planeSize > fileSize)
+		return false;
+
+	// The constants were derived from the spacing of the body that saved the file, they only fit a body with the same one.
+	// Negated comparisons also turn down NaNs of a damaged file.
+	if (header.SpatialStep != m_SpatialStep ||
+		!(header.TimeStep > 0.0f) || !std::isfinite(header.TimeStep) || header.MaxSubSteps <= 0 ||
+		!std::isfinite(header.K1) || !std::isfinite(header.K2) || !std::isfinite(header.K3) ||
+		!(header.AccumulatedTime >= 0.0f) || !std::isfinite(header.AccumulatedTime) ||
+		!(header.SleepEpsilon >= 0.0f) || !std::isfinite(header.SleepEpsilon))
+		return false;
+
+	m_TimeStep = header.TimeStep;
+	m_K1 = header.K1;
+	m_K2 = header.K2;
+	m_K3 = header.K3;
+	m_AccumulatedTime = header.AccumulatedTime;
+	m_SleepEpsilon = header.SleepEpsilon;
+	m_MaxSubSteps = header.MaxSubSteps;
+	m_LastUpdateStepCount = 0;
+	m_ValidationError = 0.0f;
+	m_PendingDisturbances.clear();
+
+	// The solutions stay in the mapping, which is copy-on-write: only the pages the simulation writes to get copied
+	// and the file itself never changes. The planes keep the mapping alive.
+	if (half)
+	{
+		m_PrevHeightsHalf.Attach(reinterpret_cast<uint16_t*>(data + header.PrevHeightsOffset), m_VertexCount, file);
+		m_CurrentHeightsHalf.Attach(reinterpret_cast<uint16_t*>(data + header.CurrentHeightsOffset), m_VertexCount, file);
+
+		m_PrevHeights.Release();
+		m_CurrentHeights.Release();
+		if (m_Validate)
+		{
+			m_PrevHeights.Resize(m_VertexCount);
+			m_CurrentHeights.Resize(m_VertexCount);
+			HalfToFloat(m_PrevHeightsHalf.GetData(), m_PrevHeights.GetData(), m_VertexCount);
+			HalfToFloat(m_CurrentHeightsHalf.GetData(), m_CurrentHeights.GetData(), m_VertexCount);
+		}
+	}
+	else
+	{
+		m_PrevHeights.Attach(reinterpret_cast<float*>(data + header.PrevHeightsOffset), m_VertexCount, file);
+		m_CurrentHeights.Attach(reinterpret_cast<float*>(data + header.CurrentHeightsOffset), m_VertexCount, file);
+
+		m_PrevHeightsHalf.Release();
+		m_CurrentHeightsHalf.Release();
+	}
+
+	m_SnapshotFileName = fileName;
+
+	bool precisionChanged = precision != m_Precision;
+	m_Precision = precision;
+
+	// Rebuild the tiles from scratch and then put them in the state they were saved in
+	m_TiledMode = false;
+	m_Tiles.clear();
+	m_ActiveTiles.clear();
+	this->SetTiledMode(header.TiledMode != 0);
+
+	const WaveSnapshotTile* tiles = reinterpret_cast<const WaveSnapshotTile*>(data + header.TilesOffset);
+	for (int i = 0; i < tileCount; ++i)
+	{
+		Tile& tile = m_Tiles[i];
+		tile.Active = tiles[i].Active != 0;
+		tile.Amplitude = tiles[i].Amplitude;
+		tile.PreviousAmplitude = tiles[i].PreviousAmplitude;
+		memcpy(tile.EdgeAmplitude, tiles[i].EdgeAmplitude, sizeof(tile.EdgeAmplitude));
+	}
+
+	if (precisionChanged)
+		this->OnPrecisionChanged();
+
+	// The attributes are computed from the restored heights the next time they are asked for,
+	// except for those of sleeping tiles, which are only ever flat.
+	this->InvalidateAttributes(0, m_NumRows);
+	for (const Tile& tile : m_Tiles)
+	{
+		if (tile.Active)
+			continue;
+
+		for (int row = tile.RowBegin; row < tile.RowEnd; ++row)
+			this->ResetAttributesRow(row, tile.ColumnBegin, tile.ColumnEnd);
+	}
+
+	return true;
+}
+
+void WaveSolver::OnPrecisionChanged()
+{
+
+}
+
+void WaveSolver::StepValidation(int stepCount)
+{
+	int rowsPerChunk = std::max<int>(1, 4096 / m_NumColumns);
+
+	for (int step = 0; step < stepCount; ++step)
+	{
+		TaskScheduler::Get().ParallelFor(1, m_NumRows - 1, rowsPerChunk,
+			[this](int rowBegin, int rowEnd)
+		{
+			for (int row = rowBegin; row < rowEnd; ++row)
+			{
+				const float* curr = &m_CurrentHeights[row * m_NumColumns];
+				WaveStepRow(&m_PrevHeights[row * m_NumColumns], curr - m_NumColumns, curr, curr + m_NumColumns, 1, m_NumColumns - 1, m_K1, m_K2, m_K3);
+			}
+		});
+
+		std::swap(m_PrevHeights, m_CurrentHeights);
+	}
+
+	std::vector<float> rowErrors(m_NumRows, 0.0f);
+
+	TaskScheduler::Get().ParallelFor(1, m_NumRows - 1, rowsPerChunk,
+		[this, &rowErrors](int rowBegin, int rowEnd)
+	{
+		std::vector<float> scratch(m_NumColumns);
+
+		for (int row = rowBegin; row < rowEnd; ++row)
+		{
+			const float* heights = this->LoadRow(false, row, 0, m_NumColumns, scratch.data());
+			const float* reference = &m_CurrentHeights[row * m_NumColumns];
+
+			float error = 0.0f;
+			for (int column = 0; column < m_NumColumns; ++column)
+				error = std::max<float>(error, std::abs(heights[column] - reference[column]));
+
+			rowErrors[row] = error;
+		}
+	});
+
+	m_ValidationError = *std::max_element(rowErrors.begin(), rowErrors.end());
+}
+
+void WaveSolver::StepRow(bool intoPrevious, int row, int columnBegin, int columnEnd)
+{
+	int rowOffset = row * m_NumColumns;
+
+	if (this->UsesHalfPrecision())
+	{
+		uint16_t* write = (intoPrevious ? m_PrevHeightsHalf : m_CurrentHeightsHalf).GetData() + rowOffset;
+		const uint16_t* curr = (intoPrevious ? m_CurrentHeightsHalf : m_PrevHeightsHalf).GetData() + rowOffset;
+		WaveStepRowHalf(write, curr - m_NumColumns, curr, curr + m_NumColumns, columnBegin, columnEnd, m_K1, m_K2, m_K3);
+	}
+	else
+	{
+		float* write = (intoPrevious ? m_PrevHeights : m_CurrentHeights).GetData() + rowOffset;
+		const float* curr = (intoPrevious ? m_CurrentHeights : m_PrevHeights).GetData() + rowOffset;
+		WaveStepRow(write, curr - m_NumColumns, curr, curr + m_NumColumns, columnBegin, columnEnd, m_K1, m_K2, m_K3);
+	}
+}
+
+const float* WaveSolver::LoadRow(bool previous, int row, int columnBegin, int columnEnd, float* scratch) const
+{
+	int rowOffset = row * m_NumColumns;
+
+	if (!this->UsesHalfPrecision())
+		return (previous ? m_PrevHeights : m_CurrentHeights).GetData() + rowOffset;
+
+	const uint16_t* heights = (previous ? m_PrevHeightsHalf : m_CurrentHeightsHalf).GetData() + rowOffset;
+	HalfToFloat(heights + columnBegin, scratch + columnBegin, columnEnd - columnBegin);
+
+	return scratch;
+}
+
+void WaveSolver::AddToCurrentRow(int row, int columnBegin, int columnEnd, const float* values)
+{
+	int rowOffset = row * m_NumColumns;
+
+	// In Float16 precision these are the fp32 copy, if validating
+	if (!m_CurrentHeights.IsEmpty())
+	{
+		float* heights = &m_CurrentHeights[rowOffset];
+		for (int column = columnBegin; column < columnEnd; ++column)
+			heights[column] += values[column];
+	}
+
+	if (!this->UsesHalfPrecision())
+		return;
+
+	// Converted in small chunks, so the row stays on the stack
+	const int chunkSize = 64;
+	float chunk[chunkSize];
+
+	uint16_t* heights = &m_CurrentHeightsHalf[rowOffset];
+	for (int chunkBegin = columnBegin; chunkBegin < columnEnd; chunkBegin += chunkSize)
+	{
+		int count = std::min<int>(chunkSize, columnEnd - chunkBegin);
+
+		HalfToFloat(heights + chunkBegin, chunk, count);
+		for (int i = 0; i < count; ++i)
+			chunk[i] += values[chunkBegin + i];
+		FloatToHalf(chunk, heights + chunkBegin, count);
+	}
+}
+
+void WaveSolver::AddToCurrentHeight(int idx, float value)
+{
+	if (!m_CurrentHeights.IsEmpty())
+		m_CurrentHeights[idx] += value;
+
+	if (this->UsesHalfPrecision())
+		m_CurrentHeightsHalf[idx] = FloatToHalf(HalfToFloat(m_CurrentHeightsHalf[idx]) + value);
+}
+
+void WaveSolver::ZeroRow(int row, int columnBegin, int columnEnd)
+{
+	int rowOffset = row * m_NumColumns;
+
+	if (this->UsesHalfPrecision())
+	{
+		std::fill(&m_PrevHeightsHalf[rowOffset + columnBegin], &m_PrevHeightsHalf[rowOffset + columnEnd], (uint16_t)0);
+		std::fill(&m_CurrentHeightsHalf[rowOffset + columnBegin], &m_CurrentHeightsHalf[rowOffset + columnEnd], (uint16_t)0);
+	}
+	else
+	{
+		std::fill(&m_PrevHeights[rowOffset + columnBegin], &m_PrevHeights[rowOffset + columnEnd], 0.0f);
+		std::fill(&m_CurrentHeights[rowOffset + columnBegin], &m_CurrentHeights[rowOffset + columnEnd], 0.0f);
+	}
+}
+
+float WaveSolver::LoadHeight(bool previous, int idx) const
+{
+	if (this->UsesHalfPrecision())
+		return HalfToFloat((previous ? m_PrevHeightsHalf : m_CurrentHeightsHalf)[idx]);
+
+	return (previous ? m_PrevHeights : m_CurrentHeights)[idx];
+}
+
+void WaveSolver::SwapSolutions()
+{
+	if (this->UsesHalfPrecision())
+		std::swap(m_PrevHeightsHalf, m_CurrentHeightsHalf);
+	else
+		std::swap(m_PrevHeights, m_CurrentHeights);
+}
+
+bool WaveSolver::UsesHalfPrecision() const
+{
+	return m_Precision == WavePrecision::Float16;
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "WaterSurface.h"
+#include "HeightPlane.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+
+// A disturbance of the water surface in world space (relative to the center of the grid)
+struct WaveDisturbance
+{
+	float X;
+	float Z;
+	float Radius;
+	float Magnitude;
+};
+
+enum class WavePrecision : char
+{
+	Float32 = 0,
+	Float16		// Heights (and attributes) stored as fp16, half the memory and bandwidth
+};
+
+// Solves the damped wave equation on a grid with a leapfrog finite difference scheme.
+// The solver only deals with heights, the attributes derived from them (normals, vertices, ...)
+// are computed by the derived class through the hooks below, see WaveEngine.
+class WaveSolver : public WaterSurface
+{
+public:
+	WaveSolver(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping);
+	WaveSolver(const WaveSolver& other) = delete;
+	WaveSolver& operator=(const WaveSolver& other) = delete;
+	~WaveSolver();
+
+	// Returns the solution of the grid point at index.
+	// x and z are derived from the row/column of the grid point, y is the solved height.
+	DirectX::XMFLOAT3 GetPosition(int idx) const override;
+
+	// Returns the solution height of the grid point at index
+	float GetHeight(int idx) const override;
+
+	// Returns the height of the grid point at index one time step before the current solution
+	float GetPreviousHeight(int idx) const;
+
+	// Returns a view of the current solution for SampleHeightField, valid until the next step or precision change
+	HeightFieldView GetHeightField() const override;
+
+	// Advances the simulation in fixed time steps, running as many as the accumulated time asks for (at most the max sub steps).
+	void Update(float dTime) override;
+
+	void Disturb(int rowIndex, int columnIndex, float magnitude);
+
+	// Queues count disturbances, they are applied in one parallel pass right before the next step.
+	// Every disturbance raises the grid points within its radius with a smooth falloff: magnitude * (1 - d^2/r^2)^2.
+	// Disturbances (partly) outside the grid are clipped, the boundary stays fixed.
+	void Disturb(const WaveDisturbance* disturbances, int count);
+
+	void SetMaxSubSteps(int maxSubSteps);
+	int GetMaxSubSteps() const;
+
+	int GetLastUpdateStepCount() const override;
+
+	// In tiled mode only the active tiles are simulated
+	int GetSimulatedCellCount() const override;
+
+	// Returns how far the accumulated time is into the next time step [0, 1].
+	// Use it to blend GetPreviousHeight and GetHeight when rendering.
+	float GetInterpolationAlpha() const;
+
+	// Advances the simulation stepCount time steps right away, regardless of the accumulated time.
+	// Use this to catch up when the simulation has fallen behind: the steps are temporally blocked,
+	// so a band of rows is advanced several steps while it is in cache before moving on to the next one.
+	// Only the heights are advanced, the attributes are brought up to date by UpdateAttributes.
+	void Step(int stepCount = 1);
+
+	// The attributes (normals, ...) are computed in bands of s_TileSize rows and cached until the next step
+	// (or disturbance) changes the heights, so bodies nobody looks at only pay for their heights.
+	// Brings the attributes of the whole grid or of the rows [rowBegin, rowEnd) up to date.
+	// Updates that write vertices leave them up to date, after the others call this once per update
+	// before querying the attributes of the derived class, its accessors don't compute anything.
+	void UpdateAttributes();
+	void UpdateAttributes(int rowBegin, int rowEnd);
+	bool AreAttributesCurrent(int rowBegin, int rowEnd) const;
+
+	// In tiled mode the grid is split in tiles of s_TileSize x s_TileSize grid points that are only
+	// simulated while they have waves in them: a tile goes to sleep (and is flattened) once its
+	// amplitude stays below the sleep epsilon, and is woken up again when a wavefront reaches its edge
+	// or when it is disturbed. The cost of a step then scales with the active area instead of the grid size.
+	void SetTiledMode(bool tiled);
+	bool IsTiledMode() const;
+	void SetSleepEpsilon(float epsilon);
+	int GetTileCount() const;
+	int GetActiveTileCount() const;
+
+	// In Float16 precision the solutions are stored as fp16, which halves the memory and bandwidth of the solver.
+	// The stencil converts on the fly (with F16C when available), the math itself is still done in fp32.
+	// fp16 has ~3 significant digits, use the validation mode to see what that does to a simulation.
+	void SetPrecision(WavePrecision precision);
+	WavePrecision GetPrecision() const;
+
+	// In validation mode an fp32 copy of a Float16 simulation runs alongside it, applying the same disturbances,
+	// and after every step the largest height difference between the two is measured.
+	// The copy ignores tiles, so in tiled mode the error includes that of putting tiles to sleep.
+	void SetValidation(bool validate);
+	bool IsValidating() const;
+
+	// Returns the largest absolute height difference to the fp32 copy after the last step
+	float GetValidationError() const;
+
+	// A snapshot holds the whole state of the simulation: both solutions, the time step and wave parameters,
+	// the accumulated time, the precision and the tiles. The file is versioned and the solutions in it start at page boundaries,
+	// RestoreSnapshot maps the file copy-on-write and simulates on the mapped solutions, nothing is read or copied up front.
+	// Disturbances queued with Disturb(const WaveDisturbance*, int) aren't part of a snapshot,
+	// the fp32 copy of the validation mode restarts from the restored heights.
+	// The file is written under a temporary name and replaces fileName once it is complete, solutions still mapped
+	// from fileName are copied out first. Returns false (leaving fileName as it was) if it can't be written.
+	bool SaveSnapshot(const std::wstring& fileName);
+
+	// Returns false (leaving the simulation as it is) if the file can't be mapped,
+	// isn't a snapshot of this version, is one of another grid size or spacing, or holds invalid constants.
+	bool RestoreSnapshot(const std::wstring& fileName);
+
+protected:
+	// Adds dTime to the accumulated time and returns how many steps to take for it.
+	int AccumulateTime(float dTime);
+
+	// Same as Step, but also computes the attributes of every row, fused with the last step while the rows are in cache,
+	// and emits every row. In tiled mode only the attributes are computed and no rows are emitted.
+	void StepAndEmit(int stepCount);
+
+	// Returns the heights of a row of the current solution, indexed by column.
+	// scratch needs room for a row, in Float16 precision the heights are converted into it.
+	const float* GetCurrentHeightsRow(int row, float* scratch) const;
+
+	// Computes the attributes of the columns [columnBegin, columnEnd) of an interior row.
+	// up, curr and down are the heights of the row and the rows above/below it, indexed by column.
+	// Called once the heights of the row and its neighbours are final, rows can be computed in parallel.
+	virtual void ComputeAttributesRow(const float* up, const float* curr, const float* down, int row, int columnBegin, int columnEnd) = 0;
+
+	// Resets the attributes of the columns [columnBegin, columnEnd) of an interior row to those of a flat grid.
+	virtual void ResetAttributesRow(int row, int columnBegin, int columnEnd) = 0;
+
+	// Called by the dense StepAndEmit for every row once the row is completely done, heights (indexed by column) and attributes.
+	virtual void EmitRow(const float* heights, int row) = 0;
+
+	// Called after the precision changed, so the attributes can follow.
+	virtual void OnPrecisionChanged();
+
+private:
+	// Advances the simulation stepCount time steps, computing the attributes and emitting the rows when emit is set.
+	void Advance(int stepCount, bool emit);
+
+	// Advances the simulation one time step and finishes every row.
+	void StepFused();
+
+	// Advances the heights stepCount time steps, without attributes.
+	void StepBlocked(int stepCount);
+
+	// Advances the heights of the active tiles one time step and puts tiles to sleep/wakes them up.
+	void StepTiled();
+
+	// Computes the attributes of a band of s_TileSize rows (only of the active tiles in tiled mode), scratch needs room for 3 rows.
+	void ComputeBandAttributes(int band, float* scratch);
+
+	// Marks the attributes of the bands overlapping the rows [rowBegin, rowEnd) as out of date.
+	void InvalidateAttributes(int rowBegin, int rowEnd);
+	void GetAttributeBands(int rowBegin, int rowEnd, int& bandBegin, int& bandEnd) const;
+
+	void WakeTile(int tileIndex);
+	void SleepTile(int tileIndex);
+
+	// Splats the queued disturbances onto the current solution.
+	void ApplyDisturbances();
+
+	// Wakes up the tiles a disturbance at the given grid point touches.
+	void WakeTilesAround(int rowIndex, int columnIndex);
+
+	// Computes the attributes of an interior row of the new solution and emits it, scratch needs room for 3 rows.
+	void FinishRow(int row, float* scratch);
+
+	// Advances the fp32 copy of the validation mode and measures the error.
+	void StepValidation(int stepCount);
+
+	// Steps the columns [columnBegin, columnEnd) of a row into the previous solution (or the current one when not intoPrevious).
+	void StepRow(bool intoPrevious, int row, int columnBegin, int columnEnd);
+
+	// Returns the heights of the columns [columnBegin, columnEnd) of a row of the previous or current solution, indexed by column.
+	// scratch needs room for a row, in Float16 precision the heights are converted into it.
+	const float* LoadRow(bool previous, int row, int columnBegin, int columnEnd, float* scratch) const;
+
+	// Adds values (indexed by column) to the columns [columnBegin, columnEnd) of a row of the current solution
+	void AddToCurrentRow(int row, int columnBegin, int columnEnd, const float* values);
+	void AddToCurrentHeight(int idx, float value);
+
+	// Flattens the columns [columnBegin, columnEnd) of a row in both solutions
+	void ZeroRow(int row, int columnBegin, int columnEnd);
+
+	float LoadHeight(bool previous, int idx) const;
+	void SwapSolutions();
+	bool UsesHalfPrecision() const;
+
+	int GetRowsPerBand() const;
+
+private:
+	// The most time steps a band advances in one go.
+	// The bands have to be at least twice this tall.
+	static const int s_MaxBlockedSteps = 8;
+
+	static const int s_TileSize = 32;
+
+	struct Tile
+	{
+		int RowBegin;
+		int RowEnd;
+		int ColumnBegin;
+		int ColumnEnd;
+
+		bool Active;
+
+		// Largest absolute height in the tile after the last and the step before that,
+		// both solutions have to be flat before the tile can sleep.
+		float Amplitude;
+		float PreviousAmplitude;
+
+		// Largest absolute height on the top, bottom, left and right edge after the last step
+		float EdgeAmplitude[4];
+	};
+
+	float m_K1;
+	float m_K2;
+	float m_K3;
+
+	float m_TimeStep;
+
+	// Time that hasn't been simulated yet, always less than one time step after an update
+	float m_AccumulatedTime = 0.0f;
+	int m_MaxSubSteps = 8;
+	int m_LastUpdateStepCount = 0;
+
+	// The solver only ever reads and writes heights, so the solutions are stored
+	// as contiguous float planes (row major, one float per grid point) instead of XMFLOAT3s.
+	// This way every cache line the stencil touches is filled with heights only.
+	// In Float16 precision the solutions are in the half planes and the float planes are
+	// the fp32 copy of the validation mode (empty when not validating).
+	// The planes can be those of a mapped snapshot file, see RestoreSnapshot.
+	HeightPlane<float> m_PrevHeights;
+	HeightPlane<float> m_CurrentHeights;
+	HeightPlane<uint16_t> m_PrevHeightsHalf;
+	HeightPlane<uint16_t> m_CurrentHeightsHalf;
+
+	// The snapshot file the planes were last attached to, empty when they own their heights
+	std::wstring m_SnapshotFileName;
+
+	WavePrecision m_Precision = WavePrecision::Float32;
+	bool m_Validate = false;
+	float m_ValidationError = 0.0f;
+
+	bool m_TiledMode = false;
+	float m_SleepEpsilon = 1e-4f;
+	int m_TileRowCount = 0;
+	int m_TileColumnCount = 0;
+	std::vector<Tile> m_Tiles;
+	std::vector<int> m_ActiveTiles;
+
+	// Whether the attributes of a band of s_TileSize rows are up to date (a char per band, so bands can be updated in parallel)
+	std::vector<char> m_AttributeBandsCurrent;
+
+	// Disturbances queued for the next step and the indices of the ones touching each band of
+	// s_TileSize rows, sorted by band (m_DisturbanceBandOffsets[band] is the first of a band).
+	std::vector<WaveDisturbance> m_PendingDisturbances;
+	std::vector<int> m_SortedDisturbances;
+	std::vector<int> m_DisturbanceBandOffsets;
+};
@@ -26,6 +26,7 @@
 #include "3.2 LightningWaves/LightningWavesApp.h"
 #endif
 
+#include "MeshOptimizerReport.h"
 #include "Utils.h"
 
 #include <dxgidebug.h>
@@ -75,8 +76,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	return app->Start();
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Offline tools run in the console, without a window
+	if (argc > 1 && std::string(argv[1]) == "--mesh-report")
+		return RunMeshOptimizerReport(std::vector<std::string>(argv + 2, argv + argc));
+
 	int err = 0;
 	try
 	{
@@ -1,5 +1,6 @@
 #include "DrawingD3DAppII.h"
-#include "1.0 Core/GeometryGenerator.h"
+#include "1.0 Core/IndexData.h"
+#include "1.0 Core/MeshCache.h"
 
 #include <DirectXColors.h>
 
@@ -222,90 +223,93 @@ void DrawingD3DAppII::BuildRootSignature()
 
 void DrawingD3DAppII::BuildShapeGeometry()
 {
-	GeometryGenerator geoGen;
+	MeshCache& meshCache = MeshCache::Get();
 
-	GeometryGenerator::MeshData box = geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(0.5f, 20, 20);
-	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
+	std::shared_ptr<const GeometryGenerator::MeshData> box = meshCache.CreateBox(1.5f, 0.5f, 1.5f, 3);
+	std::shared_ptr<const GeometryGenerator::MeshData> grid = meshCache.CreateGrid(20.0f, 30.0f, 60, 40);
+	std::shared_ptr<const GeometryGenerator::MeshData> sphere = meshCache.CreateSphere(0.5f, 20, 20);
+	std::shared_ptr<const GeometryGenerator::MeshData> cylinder = meshCache.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
 	
 	// We are concatenating all the geometry into one big vertex/index buffer.
 	// so define the regions in the buffer each submesh covers.
 
 	// cache the vertex offsets to each object in concatenated vertex buffer'
 	UINT boxVertexOffset = 0;
-	UINT gridVertexOffset = (UINT)box.Vertices.size();
-	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
-	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere.Vertices.size();
+	UINT gridVertexOffset = (UINT)box->Vertices.size();
+	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid->Vertices.size();
+	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere->Vertices.size();
 
 	// Cache the starting index for each object in the concatenated index buffer.
 	UINT boxIndexOffset = 0;
-	UINT gridIndexOffset = (UINT)box.Indices32.size();
-	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid.Indices32.size();
-	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere.Indices32.size();
+	UINT gridIndexOffset = (UINT)box->Indices32.size();
+	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid->Indices32.size();
+	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere->Indices32.size();
 
 	// Define the submesh geometry that cover different regions of the vertex index buffers.
 
 	SubMeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
+	boxSubmesh.IndexCount = (UINT)box->Indices32.size();
 	boxSubmesh.StartIndexLocation = boxIndexOffset;
 	boxSubmesh.BaseVertexLocation = boxVertexOffset;
 
 	SubMeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
+	gridSubmesh.IndexCount = (UINT)grid->Indices32.size();
 	gridSubmesh.StartIndexLocation = gridIndexOffset;
 	gridSubmesh.BaseVertexLocation = gridVertexOffset;
 
 	SubMeshGeometry sphereSubMesh;
-	sphereSubMesh.IndexCount = (UINT)sphere.Indices32.size();
+	sphereSubMesh.IndexCount = (UINT)sphere->Indices32.size();
 	sphereSubMesh.StartIndexLocation = sphereIndexOffset;
 	sphereSubMesh.BaseVertexLocation = sphereVertexOffset;
 
 	SubMeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
+	cylinderSubmesh.IndexCount = (UINT)cylinder->Indices32.size();
 	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
 	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
 
 	// Extract the vertex elements we are interested in and pach the vertices
 	// of all the meshes into one vertex buffer.
 
-	size_t totalVertexCount = box.Vertices.size() + grid.Vertices.size() + sphere.Vertices.size() + cylinder.Vertices.size();
+	size_t totalVertexCount = box->Vertices.size() + grid->Vertices.size() + sphere->Vertices.size() + cylinder->Vertices.size();
 
 	std::vector<Vertex> vertices(totalVertexCount);
 
 	UINT k = 0;
-	for (size_t i = 0; i < box.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < box->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = box.Vertices[i].Position;
+		vertices[k].Pos = box->Vertices[i].Position;
 		vertices[k].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
 	}
 
-	for (size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < grid->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = grid.Vertices[i].Position;
+		vertices[k].Pos = grid->Vertices[i].Position;
 		vertices[k].Color = XMFLOAT4(DirectX::Colors::ForestGreen);
 	}
 
-	for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < sphere->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
+		vertices[k].Pos = sphere->Vertices[i].Position;
 		vertices[k].Color = XMFLOAT4(DirectX::Colors::Crimson);
 	}
 	
-	for (size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < cylinder->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = cylinder.Vertices[i].Position;
+		vertices[k].Pos = cylinder->Vertices[i].Position;
 		vertices[k].Color = XMFLOAT4(DirectX::Colors::SteelBlue);
 	}
 
-	std::vector<uint16_t> indices;
-	indices.insert(indices.end(), box.GetIndices16().begin(), box.GetIndices16().end());
-	indices.insert(indices.end(), grid.GetIndices16().begin(), grid.GetIndices16().end());
-	indices.insert(indices.end(), sphere.GetIndices16().begin(), sphere.GetIndices16().end());
-	indices.insert(indices.end(), cylinder.GetIndices16().begin(), cylinder.GetIndices16().end());
+	std::vector<uint32_t> indices32;
+	indices32.reserve(box->Indices32.size() + grid->Indices32.size() + sphere->Indices32.size() + cylinder->Indices32.size());
+	indices32.insert(indices32.end(), box->Indices32.begin(), box->Indices32.end());
+	indices32.insert(indices32.end(), grid->Indices32.begin(), grid->Indices32.end());
+	indices32.insert(indices32.end(), sphere->Indices32.begin(), sphere->Indices32.end());
+	indices32.insert(indices32.end(), cylinder->Indices32.begin(), cylinder->Indices32.end());
+
+	IndexData indices(std::move(indices32));
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
+	const UINT ibByteSize = (UINT)indices.GetByteSize();
 
 	std::unique_ptr<MeshGeometry> geometry = std::make_unique<MeshGeometry>();
 	geometry->Name = "shapeGeo";
@@ -314,14 +318,14 @@ void DrawingD3DAppII::BuildShapeGeometry()
 	memcpy(geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geometry->IndexBufferCPU));
-	memcpy(geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	memcpy(geometry->IndexBufferCPU->GetBufferPointer(), indices.GetData(), ibByteSize);
 
 	geometry->VertexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), vertices.data(), vbByteSize, geometry->VertexBufferUploader);
-	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.data(), ibByteSize, geometry->IndexBufferUploader);
+	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.GetData(), ibByteSize, geometry->IndexBufferUploader);
 
 	geometry->VertexByteStride = sizeof(Vertex);
 	geometry->VertexBufferByteSize = vbByteSize;
-	geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geometry->IndexFormat = indices.GetFormat();
 	geometry->IndexBufferByteSize = ibByteSize;
 
 	geometry->DrawArgs["box"] = boxSubmesh;
@@ -3,7 +3,8 @@
 #include <DirectXColors.h>
 #include <iostream>
 
-#include "1.0 Core/GeometryGenerator.h"
+#include "1.0 Core/IndexData.h"
+#include "1.0 Core/MeshCache.h"
 #include "1.0 Core/FrameResource.h"
 
 using namespace DirectX;
@@ -20,7 +21,8 @@ HRESULT DrawingD3DAppIII::Initialize()
 
 	ThrowIfFailed(m_CommandList->Reset(m_DirectCmdListAlloc.Get(), nullptr));
 
-	m_Waves = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	int wavesBody = m_WaterSimulation.AddBody(std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f));
+	m_Waves = &m_WaterSimulation.GetEngine<Waves>(wavesBody);
 
 	this->BuildRootSignature();
 	this->BuildShadersAndInputLayout();
@@ -210,16 +212,16 @@ void DrawingD3DAppIII::BuildShadersAndInputLayout()
 
 void DrawingD3DAppIII::BuildLandGeometry()
 {
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 50, 50);
+	MeshCache& meshCache = MeshCache::Get();
+	std::shared_ptr<const GeometryGenerator::MeshData> grid = meshCache.CreateGrid(160.0f, 160.0f, 50, 50);
 
 	// Extract the vertex elements we are interested and apply the height function to each vertex
 	// In addition, color the vertices based on their height so we have sandy looking beaches, grassy low hills,
 	// and snow mountain peaks.
-	std::vector<Vertex> vertices(grid.Vertices.size());
-	for (size_t i = 0; i < grid.Vertices.size(); ++i)
+	std::vector<Vertex> vertices(grid->Vertices.size());
+	for (size_t i = 0; i < grid->Vertices.size(); ++i)
 	{
-		XMFLOAT3 p = grid.Vertices[i].Position;
+		XMFLOAT3 p = grid->Vertices[i].Position;
 
 		Vertex& vertex = vertices[i];;
 
@@ -256,9 +258,10 @@ void DrawingD3DAppIII::BuildLandGeometry()
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 
-	std::vector<uint16_t> indices = grid.GetIndices16();
+	// The grid has 2500 vertices, its indices go down to 16 bits in their own memory
+	IndexData indices(grid->Indices32.data(), grid->Indices32.size());
 
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
+	const UINT ibByteSize = (UINT)indices.GetByteSize();
 
 	std::unique_ptr<MeshGeometry> geometry = std::make_unique<MeshGeometry>();
 	geometry->Name = "landGeo";
@@ -267,18 +270,18 @@ void DrawingD3DAppIII::BuildLandGeometry()
 	CopyMemory(geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geometry->IndexBufferCPU));
-	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.GetData(), ibByteSize);
 
 	geometry->VertexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), vertices.data(), vbByteSize, geometry->VertexBufferUploader);
-	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.data(), ibByteSize, geometry->IndexBufferUploader);
+	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.GetData(), ibByteSize, geometry->IndexBufferUploader);
 
 	geometry->VertexByteStride = sizeof(Vertex);
 	geometry->VertexBufferByteSize = vbByteSize;
-	geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geometry->IndexFormat = indices.GetFormat();
 	geometry->IndexBufferByteSize = ibByteSize;
 
 	SubMeshGeometry subMesh;
-	subMesh.IndexCount = (UINT)indices.size();
+	subMesh.IndexCount = (UINT)indices.GetCount();
 	subMesh.StartIndexLocation = 0;
 	subMesh.BaseVertexLocation = 0;
 
@@ -300,13 +303,13 @@ void DrawingD3DAppIII::BuildWavesGeometryBuffers()
 	{
 		for (int column = 0; column < columnCount - 1; ++column)
 		{
-			indices[k + 0] = row * rowCount + column;
-			indices[k + 1] = row * rowCount + column + 1;
-			indices[k + 2] = (row + 1) * rowCount + column;
+			indices[k + 0] = row * columnCount + column;
+			indices[k + 1] = row * columnCount + column + 1;
+			indices[k + 2] = (row + 1) * columnCount + column;
 
-			indices[k + 3] = (row + 1) * rowCount + column;
-			indices[k + 4] = row * rowCount + column + 1;
-			indices[k + 5] = (row + 1) * rowCount + column + 1;
+			indices[k + 3] = (row + 1) * columnCount + column;
+			indices[k + 4] = row * columnCount + column + 1;
+			indices[k + 5] = (row + 1) * columnCount + column + 1;
 
 			k += 6; // move to next quad
 		}
@@ -428,7 +431,7 @@ void DrawingD3DAppIII::UpdateWaves(const GameTimer& gt)
 	}
 
 	// Update the wave simulation
-	m_Waves->Update(gt.GetDeltaTime());
+	m_WaterSimulation.Update(gt.GetDeltaTime());
 
 	//UploadBuffer<Vertex>* currentWavesVB = m_CurrentFrameResource->WavesVB.get();
 
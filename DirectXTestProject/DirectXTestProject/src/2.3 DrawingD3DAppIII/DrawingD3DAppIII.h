@@ -1,6 +1,7 @@
 #pragma once
 
 #include "1.0 Core/D3DAppBase.h"
+#include "1.0 Core/WaterSimulationManager.h"
 #include "Waves.h"
 
 enum class RenderLayer : char
@@ -40,7 +41,9 @@ private:
 private:
 	std::vector<RenderItem*> m_RenderItemLayer[(int)RenderLayer::Count];
 	
-	std::unique_ptr<Waves> m_Waves;
+	// Owns and steps the water bodies of the scene, m_Waves is the lake
+	WaterSimulationManager m_WaterSimulation;
+	Waves* m_Waves = nullptr;
 
 	bool m_IsWireframe;
 	RenderItem* m_WavesRenderItem = nullptr;
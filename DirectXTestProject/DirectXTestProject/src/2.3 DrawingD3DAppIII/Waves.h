@@ -1,53 +1,26 @@
 #pragma once
 
-#include <vector>
-#include <DirectXMath.h>
+#include "1.0 Core/WaveEngine.h"
+#include "1.0 Core/Utils.h"
 
-class Waves
+// The unlit waves are plain blue, they don't need any normals or tangents
+template<>
+struct WaveVertexTraits<Vertex>
 {
-public: 
-	Waves(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping);
-	Waves(const Waves& other) = delete;
-	Waves& operator=(const Waves& other) = delete;
-	~Waves();
-
-	int GetRowCount() const;
-	int GetColumnCount() const;
-	int GetVertexCount() const;
-	int GetTriangleCount() const;
-	float GetWidth() const;
-	float GetDepth() const;
-
-	// Returns the solution at the ith grid point.
-	const DirectX::XMFLOAT3& GetPosition(int i) const;
-
-	// Returns the solition normal at the ith grid point
-	const DirectX::XMFLOAT3& GetNormal(int i) const;
-
-	// Returns the unit tangent vector at the ith grid point in the local x-axis direction
-	const DirectX::XMFLOAT3& GetTangentX(int i) const;
-
-	void Update(float dTime);
-
-	void Disturb(int rowIndex, int columnIndex, float magnitude);
-
-private:
-	int m_NumRows;
-	int m_NumColumns;
-
-	int m_VertexCount = 0;
-	int m_TriangleCount = 0;
-
-	// Simulation constants we can precompute
-	float m_K1;
-	float m_K2;
-	float m_K3;
-
-	float m_TimeStep;
-	float m_SpatialStep;
-
-	std::vector<DirectX::XMFLOAT3> m_PreviousSolution;
-	std::vector<DirectX::XMFLOAT3> m_CurrentSolution;
-	std::vector<DirectX::XMFLOAT3> m_Normals;
-	std::vector<DirectX::XMFLOAT3> m_TangentX;
+	static const bool HasNormal = false;
+	static const bool HasTangent = false;
+	static const bool HasColor = true;
+
+	static DirectX::XMFLOAT4 GetColor(float)
+	{
+		return DirectX::XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+
+	static void Write(Vertex& vertex, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT4& color)
+	{
+		vertex.Pos = position;
+		vertex.Color = color;
+	}
 };
+
+using Waves = WaveEngine<Vertex>;
@@ -3,7 +3,11 @@
 //***************************************************************************************
 
 #include "1.0 Core//d3dApp.h"
-#include "1.0 Core//GeometryGenerator.h"
+#include "1.0 Core/IndexData.h"
+#include "1.0 Core/MeshCache.h"
+#include "1.0 Core/MeshOptimizer.h"
+#include "1.0 Core/MeshSimplifier.h"
+#include "1.0 Core/VertexPacking.h"
 #include "1.0 Core/FrameResource.h"
 #include <DirectXPackedVector.h>
 #include <DirectXColors.h>
@@ -143,6 +147,7 @@ void LightningD3DApp::Update(const float dTime)
 {
 	D3DAppBase::Update(dTime);
 
+	UpdateSkullLod();
 	UpdateMaterialCBs(m_GameTimer);
 }
 
@@ -179,6 +184,9 @@ void LightningD3DApp::Draw()
 
 	this->DrawRenderItems(m_CommandList.Get(), m_OpaqueRenderItems);
 
+	m_CommandList->SetPipelineState(m_Psos["opaque_packed"].Get());
+	this->DrawRenderItems(m_CommandList.Get(), m_PackedRenderItems);
+
 	// Indicate a state transition on the resource usage.
 	m_CommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(this->GetCurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
@@ -203,6 +211,64 @@ void LightningD3DApp::Draw()
 	m_pCommandQueue->Signal(m_pFence.Get(), m_CurrentFence);
 }
 
+void LightningD3DApp::UpdateSkullLod()
+{
+	// The coarsest LOD that stays within about a pixel of the full skull at its distance from the camera
+	const XMFLOAT4X4& world = m_SkullWorld;
+	XMVECTOR skullPosition = XMVectorSet(world.m[3][0], world.m[3][1], world.m[3][2], 1.0f);
+	float skullScale = XMVectorGetX(XMVector3Length(XMVectorSet(world.m[0][0], world.m[0][1], world.m[0][2], 0.0f)));
+
+	float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&m_EyePos), skullPosition)));
+	float pixelsPerUnit = 0.5f * m_Viewport.Height * m_Proj.m[1][1] * skullScale;
+
+	int lod = SelectLod(m_SkullLodErrors, distance, pixelsPerUnit);
+
+	m_SkullRenderItem->IndexCount = m_SkullLods[lod].IndexCount;
+	m_SkullRenderItem->StartIndexLocation = m_SkullLods[lod].StartIndexLocation;
+
+	m_SkullDrawRanges.clear();
+	if (lod == 0)
+		this->CullSkullMeshlets();
+	else
+		m_SkullDrawRanges.push_back(m_SkullLods[lod]);
+}
+
+void LightningD3DApp::CullSkullMeshlets()
+{
+	// The meshlet bounds are in the space of the skull, the camera is taken there
+	XMMATRIX world = XMLoadFloat4x4(&m_SkullWorld);
+
+	XMFLOAT4X4 worldViewProj;
+	XMStoreFloat4x4(&worldViewProj, world * XMLoadFloat4x4(&m_View) * XMLoadFloat4x4(&m_Proj));
+
+	XMFLOAT3 cameraPosition;
+	XMStoreFloat3(&cameraPosition, XMVector3TransformCoord(XMLoadFloat3(&m_EyePos), XMMatrixInverse(nullptr, world)));
+
+	m_VisibleSkullMeshlets.clear();
+	CullMeshlets(m_SkullMeshlets, CreateMeshletCullView(worldViewProj, cameraPosition), m_VisibleSkullMeshlets);
+
+	// Visible meshlets that follow each other in the index buffer are drawn together
+	const SubMeshGeometry& skull = m_SkullLods[0];
+	for (uint32_t meshletIndex : m_VisibleSkullMeshlets)
+	{
+		const Meshlet& meshlet = m_SkullMeshlets.Meshlets[meshletIndex];
+		UINT startIndex = skull.StartIndexLocation + 3 * meshlet.TriangleOffset;
+		UINT indexCount = 3 * meshlet.TriangleCount;
+
+		if (!m_SkullDrawRanges.empty() && m_SkullDrawRanges.back().StartIndexLocation + m_SkullDrawRanges.back().IndexCount == startIndex)
+		{
+			m_SkullDrawRanges.back().IndexCount += indexCount;
+			continue;
+		}
+
+		SubMeshGeometry range;
+		range.IndexCount = indexCount;
+		range.StartIndexLocation = startIndex;
+		range.BaseVertexLocation = skull.BaseVertexLocation;
+		m_SkullDrawRanges.push_back(range);
+	}
+}
+
 void LightningD3DApp::UpdateMaterialCBs(const GameTimer& gt)
 {
 	UploadBuffer<MaterialConstants>* currentMaterialCB = m_CurrentFrameResource->MaterialCB.get();
@@ -264,7 +330,14 @@ void LightningD3DApp::BuildShadersAndInputLayout()
 		NULL, NULL
 	};
 
+	const D3D_SHADER_MACRO packedVerticesDefines[] =
+	{
+		"PACKED_VERTICES", "1",
+		NULL, NULL
+	};
+
 	m_Shaders["standardVS"] = CompileShader(L"../data/shaders/src/shader_lightning.fx", nullptr, "VS", "vs_5_1");
+	m_Shaders["packedVS"] = CompileShader(L"../data/shaders/src/shader_lightning.fx", packedVerticesDefines, "VS", "vs_5_1");
 	m_Shaders["opaquePS"] = CompileShader(L"../data/shaders/src/shader_lightning.fx", nullptr, "PS", "ps_5_1");
 
 	m_InputLayout =
@@ -273,94 +346,103 @@ void LightningD3DApp::BuildShadersAndInputLayout()
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
 	} };
+
+	m_PackedInputLayout =
+	{ {
+		{"POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
+	} };
 }
 
 void LightningD3DApp::BuildShapeGeometry()
 {
-	GeometryGenerator geoGen;
+	MeshCache& meshCache = MeshCache::Get();
 
-	GeometryGenerator::MeshData box = geoGen.CreateBox(1.5f, 0.5f, 1.5f, 3);
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(20.0f, 30.0f, 60, 40);
-	GeometryGenerator::MeshData sphere = geoGen.CreateSphere(0.5f, 20, 20);
-	GeometryGenerator::MeshData cylinder = geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
+	std::shared_ptr<const GeometryGenerator::MeshData> box = meshCache.CreateBox(1.5f, 0.5f, 1.5f, 3);
+	std::shared_ptr<const GeometryGenerator::MeshData> grid = meshCache.CreateGrid(20.0f, 30.0f, 60, 40);
+	std::shared_ptr<const GeometryGenerator::MeshData> sphere = meshCache.CreateSphere(0.5f, 20, 20);
+	std::shared_ptr<const GeometryGenerator::MeshData> cylinder = meshCache.CreateCylinder(0.5f, 0.3f, 3.0f, 20, 20);
 
 	// We are concatenating all the geometry into one big vertex/index buffer.
 	// so define the regions in the buffer each submesh covers.
 
 	// cache the vertex offsets to each object in concatenated vertex buffer'
 	UINT boxVertexOffset = 0;
-	UINT gridVertexOffset = (UINT)box.Vertices.size();
-	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid.Vertices.size();
-	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere.Vertices.size();
+	UINT gridVertexOffset = (UINT)box->Vertices.size();
+	UINT sphereVertexOffset = gridVertexOffset + (UINT)grid->Vertices.size();
+	UINT cylinderVertexOffset = sphereVertexOffset + (UINT)sphere->Vertices.size();
 
 	// Cache the starting index for each object in the concatenated index buffer.
 	UINT boxIndexOffset = 0;
-	UINT gridIndexOffset = (UINT)box.Indices32.size();
-	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid.Indices32.size();
-	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere.Indices32.size();
+	UINT gridIndexOffset = (UINT)box->Indices32.size();
+	UINT sphereIndexOffset = gridIndexOffset + (UINT)grid->Indices32.size();
+	UINT cylinderIndexOffset = sphereIndexOffset + (UINT)sphere->Indices32.size();
 
 	// Define the submesh geometry that cover different regions of the vertex index buffers.
 
 	SubMeshGeometry boxSubmesh;
-	boxSubmesh.IndexCount = (UINT)box.Indices32.size();
+	boxSubmesh.IndexCount = (UINT)box->Indices32.size();
 	boxSubmesh.StartIndexLocation = boxIndexOffset;
 	boxSubmesh.BaseVertexLocation = boxVertexOffset;
 
 	SubMeshGeometry gridSubmesh;
-	gridSubmesh.IndexCount = (UINT)grid.Indices32.size();
+	gridSubmesh.IndexCount = (UINT)grid->Indices32.size();
 	gridSubmesh.StartIndexLocation = gridIndexOffset;
 	gridSubmesh.BaseVertexLocation = gridVertexOffset;
 
 	SubMeshGeometry sphereSubMesh;
-	sphereSubMesh.IndexCount = (UINT)sphere.Indices32.size();
+	sphereSubMesh.IndexCount = (UINT)sphere->Indices32.size();
 	sphereSubMesh.StartIndexLocation = sphereIndexOffset;
 	sphereSubMesh.BaseVertexLocation = sphereVertexOffset;
 
 	SubMeshGeometry cylinderSubmesh;
-	cylinderSubmesh.IndexCount = (UINT)cylinder.Indices32.size();
+	cylinderSubmesh.IndexCount = (UINT)cylinder->Indices32.size();
 	cylinderSubmesh.StartIndexLocation = cylinderIndexOffset;
 	cylinderSubmesh.BaseVertexLocation = cylinderVertexOffset;
 
 	// Extract the vertex elements we are interested in and pach the vertices
 	// of all the meshes into one vertex buffer.
 
-	size_t totalVertexCount = box.Vertices.size() + grid.Vertices.size() + sphere.Vertices.size() + cylinder.Vertices.size();
+	size_t totalVertexCount = box->Vertices.size() + grid->Vertices.size() + sphere->Vertices.size() + cylinder->Vertices.size();
 
 	std::vector<LightningVertex> vertices(totalVertexCount);
 
 	UINT k = 0;
-	for (size_t i = 0; i < box.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < box->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = box.Vertices[i].Position;
-		vertices[k].Normal = box.Vertices[i].Normal;
+		vertices[k].Pos = box->Vertices[i].Position;
+		vertices[k].Normal = box->Vertices[i].Normal;
 	}
 
-	for (size_t i = 0; i < grid.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < grid->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = grid.Vertices[i].Position;
-		vertices[k].Normal = grid.Vertices[i].Normal;
+		vertices[k].Pos = grid->Vertices[i].Position;
+		vertices[k].Normal = grid->Vertices[i].Normal;
 	}
 
-	for (size_t i = 0; i < sphere.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < sphere->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = sphere.Vertices[i].Position;
-		vertices[k].Normal = sphere.Vertices[i].Normal;
+		vertices[k].Pos = sphere->Vertices[i].Position;
+		vertices[k].Normal = sphere->Vertices[i].Normal;
 	}
 
-	for (size_t i = 0; i < cylinder.Vertices.size(); ++i, ++k)
+	for (size_t i = 0; i < cylinder->Vertices.size(); ++i, ++k)
 	{
-		vertices[k].Pos = cylinder.Vertices[i].Position;
-		vertices[k].Normal = cylinder.Vertices[i].Normal;
+		vertices[k].Pos = cylinder->Vertices[i].Position;
+		vertices[k].Normal = cylinder->Vertices[i].Normal;
 	}
 
-	std::vector<uint16_t> indices;
-	indices.insert(indices.end(), box.GetIndices16().begin(), box.GetIndices16().end());
-	indices.insert(indices.end(), grid.GetIndices16().begin(), grid.GetIndices16().end());
-	indices.insert(indices.end(), sphere.GetIndices16().begin(), sphere.GetIndices16().end());
-	indices.insert(indices.end(), cylinder.GetIndices16().begin(), cylinder.GetIndices16().end());
+	std::vector<uint32_t> indices32;
+	indices32.reserve(box->Indices32.size() + grid->Indices32.size() + sphere->Indices32.size() + cylinder->Indices32.size());
+	indices32.insert(indices32.end(), box->Indices32.begin(), box->Indices32.end());
+	indices32.insert(indices32.end(), grid->Indices32.begin(), grid->Indices32.end());
+	indices32.insert(indices32.end(), sphere->Indices32.begin(), sphere->Indices32.end());
+	indices32.insert(indices32.end(), cylinder->Indices32.begin(), cylinder->Indices32.end());
+
+	IndexData indices(std::move(indices32));
 
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(LightningVertex);
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
+	const UINT ibByteSize = (UINT)indices.GetByteSize();
 
 	std::unique_ptr<MeshGeometry> geometry = std::make_unique<MeshGeometry>();
 	geometry->Name = "shapeGeo";
@@ -369,14 +451,14 @@ void LightningD3DApp::BuildShapeGeometry()
 	memcpy(geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geometry->IndexBufferCPU));
-	memcpy(geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	memcpy(geometry->IndexBufferCPU->GetBufferPointer(), indices.GetData(), ibByteSize);
 
 	geometry->VertexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), vertices.data(), vbByteSize, geometry->VertexBufferUploader);
-	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.data(), ibByteSize, geometry->IndexBufferUploader);
+	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(), m_CommandList.Get(), indices.GetData(), ibByteSize, geometry->IndexBufferUploader);
 
 	geometry->VertexByteStride = sizeof(LightningVertex);
 	geometry->VertexBufferByteSize = vbByteSize;
-	geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geometry->IndexFormat = indices.GetFormat();
 	geometry->IndexBufferByteSize = ibByteSize;
 
 	geometry->DrawArgs["box"] = boxSubmesh;
@@ -417,7 +499,7 @@ void LightningD3DApp::BuildSkullGeometry()
 	fin >> ignore;
 	fin >> ignore;
 
-	std::vector<std::int32_t> indices(3 * tcount);
+	std::vector<std::uint32_t> indices(3 * tcount);
 	for (UINT i = 0; i < tcount; ++i)
 	{
 		fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
@@ -425,40 +507,86 @@ void LightningD3DApp::BuildSkullGeometry()
 
 	fin.close();
 
+	// Reorder the triangles for the post-transform cache and then the vertices for the vertex fetch,
+	// run the app with --mesh-report ../data/Models/skull.txt for what that gains
+	OptimizeVertexCache(indices.data(), indices.size(), vcount);
+	OptimizeVertexFetch(vertices, indices.data(), indices.size());
+
+	MeshSource skullSource;
+	skullSource.Indices = indices.data();
+	skullSource.IndexCount = indices.size();
+	skullSource.Positions = &vertices[0].Pos;
+	skullSource.PositionStride = sizeof(LightningVertex);
+	skullSource.VertexCount = (UINT)vertices.size();
+
+	// Meshlets of the skull, so its clusters can be culled on their own (see CullSkullMeshlets)
+	m_SkullMeshlets = BuildMeshlets(skullSource);
+
+	// LODs at half, a quarter and an eighth of the triangles go after the full skull in the index buffer
+	// (which moves the indices skullSource points to)
+	std::vector<MeshLod> skullLods = BuildLodChain(skullSource);
+
+	SubMeshGeometry submesh;
+	submesh.IndexCount = (UINT)indices.size();
+	submesh.StartIndexLocation = 0;
+	submesh.BaseVertexLocation = 0;
+	m_SkullLods.push_back(submesh);
+	m_SkullLodErrors.push_back(0.0f);
+
+	for (MeshLod& lod : skullLods)
+	{
+		OptimizeVertexCache(lod.Indices.data(), lod.Indices.size(), (UINT)vertices.size());
+
+		submesh.IndexCount = (UINT)lod.Indices.size();
+		submesh.StartIndexLocation = (UINT)indices.size();
+		m_SkullLods.push_back(submesh);
+		m_SkullLodErrors.push_back(lod.Error);
+
+		indices.insert(indices.end(), lod.Indices.begin(), lod.Indices.end());
+	}
+
+	// The vertex buffer holds the packed vertices, half the size of the full ones. The bounds are a cube
+	// so the dequantize transform is a uniform scale that the normals can go through with the world matrix.
+	VertexQuantization quantization = ComputeVertexQuantization(&vertices[0].Pos, sizeof(LightningVertex), vertices.size(), true);
+	m_SkullDequantizeTransform = quantization.GetDequantizeTransform();
+
+	std::vector<PackedLightningVertex> packedVertices(vertices.size());
+	PackPositions(&vertices[0].Pos, sizeof(LightningVertex), vertices.size(), quantization, packedVertices[0].Position, sizeof(PackedLightningVertex));
+	PackUnitVectors(&vertices[0].Normal, sizeof(LightningVertex), vertices.size(), packedVertices[0].Normal, sizeof(PackedLightningVertex));
+
 	//
 	// Pack the indices of all the meshes into one index buffer.
 	//
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(LightningVertex);
+	const UINT vbByteSize = (UINT)packedVertices.size() * sizeof(PackedLightningVertex);
 
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+	// The skull's 31K vertices fit in 16 bit indices, for the LODs too
+	IndexData indexData(std::move(indices));
+	const UINT ibByteSize = (UINT)indexData.GetByteSize();
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "skullGeo";
 
 	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), packedVertices.data(), vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indexData.GetData(), ibByteSize);
 
 	geo->VertexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(),
-		m_CommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+		m_CommandList.Get(), packedVertices.data(), vbByteSize, geo->VertexBufferUploader);
 
 	geo->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(),
-		m_CommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+		m_CommandList.Get(), indexData.GetData(), ibByteSize, geo->IndexBufferUploader);
 
-	geo->VertexByteStride = sizeof(LightningVertex);
+	geo->VertexByteStride = sizeof(PackedLightningVertex);
 	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
+	geo->IndexFormat = indexData.GetFormat();
 	geo->IndexBufferByteSize = ibByteSize;
 
-	SubMeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
-
-	geo->DrawArgs["skull"] = submesh;
+	geo->DrawArgs["skull"] = m_SkullLods[0];
+	for (size_t i = 1; i < m_SkullLods.size(); ++i)
+		geo->DrawArgs["skull_lod" + std::to_string(i)] = m_SkullLods[i];
 
 	m_Geometries[geo->Name] = std::move(geo);
 }
@@ -494,6 +622,18 @@ void LightningD3DApp::BuildPsos()
 	opaquePsoDesc.SampleDesc.Quality = m_4xMsaaEnabled ? (m_4xMsaaQuality - 1) : 0;
 	opaquePsoDesc.DSVFormat = m_DepthStencilFormat;
 	ThrowIfFailed(m_pDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&m_OpaquePSO)));
+
+	//
+	// PSO for opaque objects with packed vertices.
+	//
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC opaquePackedPsoDesc = opaquePsoDesc;
+	opaquePackedPsoDesc.InputLayout = { m_PackedInputLayout.data(), (UINT)m_PackedInputLayout.size() };
+	opaquePackedPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(m_Shaders["packedVS"]->GetBufferPointer()),
+		m_Shaders["packedVS"]->GetBufferSize()
+	};
+	ThrowIfFailed(m_pDevice->CreateGraphicsPipelineState(&opaquePackedPsoDesc, IID_PPV_ARGS(&m_Psos["opaque_packed"])));
 }
 
 void LightningD3DApp::BuildFrameResources()
@@ -576,7 +716,8 @@ void LightningD3DApp::BuildRenderItems()
 	m_RenderItems.push_back(std::move(gridRenderItem));
 
 	auto skullRitem = std::make_unique<RenderItem>();
-	XMStoreFloat4x4(&skullRitem->World, XMMatrixScaling(0.5f, 0.5f, 0.5f)*XMMatrixTranslation(0.0f, 1.0f, 0.0f));
+	XMStoreFloat4x4(&m_SkullWorld, XMMatrixScaling(0.5f, 0.5f, 0.5f)*XMMatrixTranslation(0.0f, 1.0f, 0.0f));
+	XMStoreFloat4x4(&skullRitem->World, XMLoadFloat4x4(&m_SkullDequantizeTransform) * XMLoadFloat4x4(&m_SkullWorld));
 	skullRitem->TexTransform = MAT_4_IDENTITY;
 	skullRitem->ObjCBIndex = 2;
 	skullRitem->Material = m_Materials["skullMat"].get();
@@ -585,6 +726,7 @@ void LightningD3DApp::BuildRenderItems()
 	skullRitem->IndexCount = skullRitem->Geometry->DrawArgs["skull"].IndexCount;
 	skullRitem->StartIndexLocation = skullRitem->Geometry->DrawArgs["skull"].StartIndexLocation;
 	skullRitem->BaseVertexLocation = skullRitem->Geometry->DrawArgs["skull"].BaseVertexLocation;
+	m_SkullRenderItem = skullRitem.get();
 	m_RenderItems.push_back(std::move(skullRitem));
 
 	XMMATRIX brickTexTransform = XMMatrixScaling(1.0f, 1.0f, 1.0f);
@@ -648,9 +790,14 @@ void LightningD3DApp::BuildRenderItems()
 		m_RenderItems.push_back(std::move(rightSphereRitem));
 	}
 
-	// All the render items are opaque.
+	// All the render items are opaque, the skull has packed vertices.
 	for (auto& e : m_RenderItems)
-		m_OpaqueRenderItems.push_back(e.get());
+	{
+		if (e.get() == m_SkullRenderItem)
+			m_PackedRenderItems.push_back(e.get());
+		else
+			m_OpaqueRenderItems.push_back(e.get());
+	}
 }
 
 void LightningD3DApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
@@ -676,6 +823,15 @@ void LightningD3DApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const
 		cmdList->SetGraphicsRootConstantBufferView(0, objCBAddress);
 		cmdList->SetGraphicsRootConstantBufferView(1, matCBAddress);
 
+		// The skull only draws what is left of it after culling its meshlets
+		if (ri == m_SkullRenderItem)
+		{
+			for (const SubMeshGeometry& range : m_SkullDrawRanges)
+				cmdList->DrawIndexedInstanced(range.IndexCount, 1, range.StartIndexLocation, range.BaseVertexLocation, 0);
+
+			continue;
+		}
+
 		cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
 	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "1.0 Core/D3DAppBase.h"
+#include "1.0 Core/MeshletBuilder.h"
 
 class LightningD3DApp : public D3DAppBase
 {
@@ -24,14 +25,33 @@ private:
 	void BuildRenderItems();
 	void BuildSkullGeometry();
 
+	void UpdateSkullLod();
+	void CullSkullMeshlets();
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& renderItems);
 
 private:
 	std::unordered_map<std::string, std::unique_ptr<Material>> m_Materials;
 	std::vector<RenderItem*> m_OpaqueRenderItems;
+	std::vector<RenderItem*> m_PackedRenderItems;
+
+	// The full skull first, then its LODs, and their errors (see SelectLod)
+	RenderItem* m_SkullRenderItem = nullptr;
+	std::vector<SubMeshGeometry> m_SkullLods;
+	std::vector<float> m_SkullLodErrors;
+
+	// The meshlets of the full skull are runs of its triangles in index order. While the full skull is drawn,
+	// only the meshlets in view and not facing away are, in as few draws as there are runs of them.
+	MeshletMesh m_SkullMeshlets;
+	std::vector<uint32_t> m_VisibleSkullMeshlets;
+	std::vector<SubMeshGeometry> m_SkullDrawRanges;
+
+	// The skull vertices are packed, its render item's world matrix is the dequantize transform then m_SkullWorld
+	DirectX::XMFLOAT4X4 m_SkullDequantizeTransform = MAT_4_IDENTITY;
+	DirectX::XMFLOAT4X4 m_SkullWorld = MAT_4_IDENTITY;
 
 	std::array<D3D12_INPUT_ELEMENT_DESC, 3> m_InputLayout;
+	std::array<D3D12_INPUT_ELEMENT_DESC, 2> m_PackedInputLayout;
 
 };
 
@@ -1,51 +1,26 @@
 #pragma once
 
-#include <vector>
-#include <DirectXMath.h>
+#include "1.0 Core/WaveEngine.h"
+#include "1.0 Core/Utils.h"
 
-class LightningWaves
+// The lit waves only need positions and normals
+template<>
+struct WaveVertexTraits<LightningVertex>
 {
-public:
-	LightningWaves(int numRows, int numColumns, float spatialStep, float timeStep, float speed, float damping);
-	LightningWaves(const LightningWaves& other) = delete;
-	LightningWaves& operator=(const LightningWaves& other) = delete;
-	~LightningWaves();
-
-	int GetRowCount() const;
-	int GetColumnCount() const;
-	int GetVertexCount() const;
-	int GetTriangleCount() const;
-	float GetWidth() const;
-	float GetDepth() const;
-
-	// Returns the solution of the grid point at index
-	const DirectX::XMFLOAT3& GetPosition(int idx) const;
-
-	// Returns the solution normal of the grid at index
-	const DirectX::XMFLOAT3& GetNormal(int idx) const;
-
-	// Returns the unit tangent vector of the grid at index in the local x-axis direction
-	const DirectX::XMFLOAT3& GetTangentX(int idx) const;
-	
-	void Update(float dTime);
-	void Disturb(int rowIndex, int columnIndex, float magnitude);
-
-private:
-	int m_NumRows;
-	int m_NumColumns;
-
-	int m_VertexCount;
-	int m_TriangleCount;
-
-	float m_K1;
-	float m_K2;
-	float m_K3;
-
-	float m_TimeStep;
-	float m_SpatialStep;
-
-	std::vector<DirectX::XMFLOAT3> m_PrevSolution;
-	std::vector<DirectX::XMFLOAT3> m_CurrentSolution;
-	std::vector<DirectX::XMFLOAT3> m_Normals;
-	std::vector<DirectX::XMFLOAT3> m_TangentX;
-};
\ No newline at end of file
+	static const bool HasNormal = true;
+	static const bool HasTangent = false;
+	static const bool HasColor = false;
+
+	static DirectX::XMFLOAT4 GetColor(float)
+	{
+		return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	static void Write(LightningVertex& vertex, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT3&, const DirectX::XMFLOAT4&)
+	{
+		vertex.Pos = position;
+		vertex.Normal = normal;
+	}
+};
+
+using LightningWaves = WaveEngine<LightningVertex>;
@@ -1,11 +1,19 @@
 #include "LightningWavesApp.h"
-#include "1.0 Core/GeometryGenerator.h"
+#include "1.0 Core/IndexData.h"
+#include "1.0 Core/MeshCache.h"
 
 #include <DirectXColors.h>
 
 #include <iostream>
+#include <string>
 using namespace DirectX;
 
+// Where F5 saves the lake to and F9 (and the start of the app) restores it from
+static const wchar_t* s_WavesSnapshotFile = L"../data/lightning_waves.snapshot";
+
+// The ocean patch is as big as a quarter of the land, it is tiled in a ring of 12 around the land (160 x 160)
+static const float s_OceanPatchSize = 80.0f;
+
 LightningWavesApp::LightningWavesApp(HINSTANCE hInstance) :
 	D3DAppBase(hInstance)
 {
@@ -22,7 +30,19 @@ HRESULT LightningWavesApp::Initialize()
 	// This is hardware specific, so we have to query this information
 	m_CbvSrvDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
-	m_Waves = std::make_unique<LightningWaves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	m_WavesBody = m_WaterSimulation.AddBody(std::make_unique<LightningWaves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f));
+	m_Waves = &m_WaterSimulation.GetEngine<LightningWaves>(m_WavesBody);
+
+	OceanSettings oceanSettings;
+	oceanSettings.Resolution = 64;
+	oceanSettings.PatchSize = s_OceanPatchSize;
+
+	m_OceanBody = m_WaterSimulation.AddBody(std::make_unique<OceanEngine<LightningVertex>>(oceanSettings));
+	m_Ocean = &m_WaterSimulation.GetEngine<OceanEngine<LightningVertex>>(m_OceanBody);
+
+	// Carry on with the lake of the last run, if it was saved
+	if (m_Waves->RestoreSnapshot(s_WavesSnapshotFile))
+		this->ShowStatus(L"lake of the last run restored");
 
 	this->BuildRootSignature();
 	this->BuildShadersAndInputLayout();
@@ -44,6 +64,16 @@ HRESULT LightningWavesApp::Initialize()
 	return S_OK;
 }
 
+// True on the frame the key goes down, wasDown carries its state over from the frame before
+static bool WasKeyPressed(int key, bool& wasDown)
+{
+	bool isDown = (GetAsyncKeyState(key) & 0x8000) != 0;
+	bool pressed = isDown && !wasDown;
+	wasDown = isDown;
+
+	return pressed;
+}
+
 void LightningWavesApp::Update(const float dTime)
 {
 	D3DAppBase::Update(dTime);
@@ -172,6 +202,30 @@ void LightningWavesApp::OnKeyboardInput(const GameTimer& gt)
 		m_SunPhi += 1.0f * dt;
 
 	m_SunPhi = Clamp(m_SunPhi, 0.1f, XM_PIDIV2);
+
+	// T switches to tiled stepping, which lets quiet parts of the lake sleep (and flattens them) to save time
+	if (WasKeyPressed('T', m_TiledModeKeyDown))
+		m_Waves->SetTiledMode(!m_Waves->IsTiledMode());
+
+	if (WasKeyPressed(VK_F5, m_SaveKeyDown))
+	{
+		bool saved = m_Waves->SaveSnapshot(s_WavesSnapshotFile);
+		this->ShowStatus(saved ? L"lake saved" : L"the lake couldn't be saved");
+	}
+
+	if (WasKeyPressed(VK_F9, m_RestoreKeyDown))
+	{
+		bool restored = m_Waves->RestoreSnapshot(s_WavesSnapshotFile);
+		this->ShowStatus(restored ? L"lake restored" : L"there is no saved lake to restore");
+	}
+}
+
+void LightningWavesApp::ShowStatus(const std::wstring& status)
+{
+	std::wstring text = m_AppName + L" - " + status;
+	SetWindowTextW(m_WindowHandle, text.c_str());
+
+	OutputDebugStringW((text + L"\n").c_str());
 }
 
 void LightningWavesApp::BuildRootSignature()
@@ -226,7 +280,7 @@ void LightningWavesApp::BuildFrameResources()
 	for (int i = 0; i < gNumFrameResources; ++i)
 	{
 		m_FrameResources.push_back(std::make_unique<FrameResource>(m_pDevice.Get(),
-			1, (UINT)m_RenderItems.size(), (UINT)m_Materials.size(), m_Waves->GetVertexCount()));
+			1, (UINT)m_RenderItems.size(), (UINT)m_Materials.size(), m_Waves->GetVertexCount(), m_Ocean->GetVertexCount()));
 	}
 }
 
@@ -287,23 +341,64 @@ void LightningWavesApp::BuildMaterials()
 
 void LightningWavesApp::BuildRenderItems()
 {
-	std::unique_ptr<RenderItem> wavesRenderItem = std::make_unique<RenderItem>();
-	wavesRenderItem->World = MAT_4_IDENTITY;
-	wavesRenderItem->ObjCBIndex = 0;
-	wavesRenderItem->Material = m_Materials["water"].get();
-	wavesRenderItem->Geometry = m_Geometries["waterGeo"].get();
-	wavesRenderItem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	wavesRenderItem->IndexCount = wavesRenderItem->Geometry->DrawArgs["grid"].IndexCount;
-	wavesRenderItem->StartIndexLocation = wavesRenderItem->Geometry->DrawArgs["grid"].StartIndexLocation;
-	wavesRenderItem->BaseVertexLocation = wavesRenderItem->Geometry->DrawArgs["grid"].BaseVertexLocation;
-
-	m_WavesRenderItem = wavesRenderItem.get();
+	// One render item per patch of the water grid, they all share the dynamic vertex buffer
+	for (int patch = 0; patch < m_WavesPatchCount; ++patch)
+	{
+		std::string patchName = "grid" + std::to_string(patch);
+
+		std::unique_ptr<RenderItem> wavesRenderItem = std::make_unique<RenderItem>();
+		wavesRenderItem->World = MAT_4_IDENTITY;
+		wavesRenderItem->ObjCBIndex = (UINT)m_RenderItems.size();
+		wavesRenderItem->Material = m_Materials["water"].get();
+		wavesRenderItem->Geometry = m_Geometries["waterGeo"].get();
+		wavesRenderItem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+		wavesRenderItem->IndexCount = wavesRenderItem->Geometry->DrawArgs[patchName].IndexCount;
+		wavesRenderItem->StartIndexLocation = wavesRenderItem->Geometry->DrawArgs[patchName].StartIndexLocation;
+		wavesRenderItem->BaseVertexLocation = wavesRenderItem->Geometry->DrawArgs[patchName].BaseVertexLocation;
+
+		if (patch == 0)
+			m_WavesRenderItem = wavesRenderItem.get();
+
+		m_OpaqueRenderItems.push_back(wavesRenderItem.get());
+		m_RenderItems.push_back(std::move(wavesRenderItem));
+	}
 
-	m_OpaqueRenderItems.push_back(wavesRenderItem.get());
+	// The ocean patch tiles seamlessly, every tile of the ring draws the same vertices moved by its world matrix
+	for (int tileZ = -2; tileZ < 2; ++tileZ)
+	{
+		for (int tileX = -2; tileX < 2; ++tileX)
+		{
+			// The inner 2 x 2 tiles are covered by the land
+			if (tileX >= -1 && tileX < 1 && tileZ >= -1 && tileZ < 1)
+				continue;
+
+			XMMATRIX world = XMMatrixTranslation((tileX + 0.5f) * s_OceanPatchSize, 0.0f, (tileZ + 0.5f) * s_OceanPatchSize);
+
+			for (int patch = 0; patch < m_OceanPatchCount; ++patch)
+			{
+				std::string patchName = "grid" + std::to_string(patch);
+
+				std::unique_ptr<RenderItem> oceanRenderItem = std::make_unique<RenderItem>();
+				XMStoreFloat4x4(&oceanRenderItem->World, world);
+				oceanRenderItem->ObjCBIndex = (UINT)m_RenderItems.size();
+				oceanRenderItem->Material = m_Materials["water"].get();
+				oceanRenderItem->Geometry = m_Geometries["oceanGeo"].get();
+				oceanRenderItem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+				oceanRenderItem->IndexCount = oceanRenderItem->Geometry->DrawArgs[patchName].IndexCount;
+				oceanRenderItem->StartIndexLocation = oceanRenderItem->Geometry->DrawArgs[patchName].StartIndexLocation;
+				oceanRenderItem->BaseVertexLocation = oceanRenderItem->Geometry->DrawArgs[patchName].BaseVertexLocation;
+
+				m_OceanRenderItem = oceanRenderItem.get();
+
+				m_OpaqueRenderItems.push_back(oceanRenderItem.get());
+				m_RenderItems.push_back(std::move(oceanRenderItem));
+			}
+		}
+	}
 
 	std::unique_ptr<RenderItem> gridRenderItem = std::make_unique<RenderItem>();
 	gridRenderItem->World = MAT_4_IDENTITY;
-	gridRenderItem->ObjCBIndex = 1;
+	gridRenderItem->ObjCBIndex = (UINT)m_RenderItems.size();
 	gridRenderItem->Material = m_Materials["grass"].get();
 	gridRenderItem->Geometry = m_Geometries["landGeo"].get();
 	gridRenderItem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
@@ -313,7 +408,6 @@ void LightningWavesApp::BuildRenderItems()
 
 	m_OpaqueRenderItems.push_back(gridRenderItem.get());
 
-	m_RenderItems.push_back(std::move(wavesRenderItem));
 	m_RenderItems.push_back(std::move(gridRenderItem));
 }
 
@@ -369,62 +463,96 @@ void LightningWavesApp::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, cons
 
 void LightningWavesApp::UpdateWaves(const GameTimer& gt)
 {
-	// Every quarter second, generate a random wave.
+	// Every quarter second, generate a random wave where there is water:
+	// the islands stick out of the lake (its surface is at 0) and drops falling on them make no waves.
 	static float t_base = 0.0f;
 
 	if ((m_GameTimer.GetGameTime() - t_base) >= 0.25f)
 	{
 		t_base += 0.25f;
 
-		int i = Rand(4, m_Waves->GetRowCount() - 5);
-		int j = Rand(4, m_Waves->GetColumnCount() - 5);
+		// A few spots are tried at once, the land under them is sampled in one batch
+		const int spotCount = 8;
+		int rows[spotCount];
+		int columns[spotCount];
+		float x[spotCount];
+		float z[spotCount];
+		float landHeights[spotCount];
 
-		float r = RandF(0.2f, 0.5f);
+		for (int spot = 0; spot < spotCount; ++spot)
+		{
+			rows[spot] = Rand(4, m_Waves->GetRowCount() - 5);
+			columns[spot] = Rand(4, m_Waves->GetColumnCount() - 5);
 
-		m_Waves->Disturb(i, j, r);
-	}
+			XMFLOAT3 position = m_Waves->GetPosition(rows[spot] * m_Waves->GetColumnCount() + columns[spot]);
+			x[spot] = position.x;
+			z[spot] = position.z;
+		}
 
-	// Update the wave simulation
-	m_Waves->Update(gt.GetDeltaTime());
+		SampleHeightField(m_LandHeightField, x, z, spotCount, landHeights, nullptr);
 
-	// Update the wave vertex buffer with the new solution
-	UploadBuffer<LightningVertex>* currWaveVB = m_CurrentFrameResource->WavesVB.get();
-	for (int i = 0; i < m_Waves->GetVertexCount(); ++i)
-	{
-		LightningVertex v;
-		
-		v.Pos = m_Waves->GetPosition(i);
-		v.Normal = m_Waves->GetNormal(i);
-
-		currWaveVB->CopyData(i, v);
+		for (int spot = 0; spot < spotCount; ++spot)
+		{
+			if (landHeights[spot] < 0.0f)
+			{
+				m_Waves->Disturb(rows[spot], columns[spot], RandF(0.2f, 0.5f));
+				break;
+			}
+		}
 	}
 
+	// Update the water bodies and write the new solutions straight into the current frame's vertex buffers
+	UploadBuffer<LightningVertex>* currWaveVB = m_CurrentFrameResource->WavesVB.get();
+	UploadBuffer<LightningVertex>* currOceanVB = m_CurrentFrameResource->OceanVB.get();
+	m_WaterSimulation.SetVertexOutput(m_WavesBody, currWaveVB->GetMappedData());
+	m_WaterSimulation.SetVertexOutput(m_OceanBody, currOceanVB->GetMappedData());
+	m_WaterSimulation.Update(gt.GetDeltaTime());
+
 	// Set the dynamic vb of the wave renderitem to the current frame VB.
+	// All patches (and ocean tiles) share the geometry, so this updates them all.
 	m_WavesRenderItem->Geometry->VertexBufferGPU = currWaveVB->GetResource();
+	m_OceanRenderItem->Geometry->VertexBufferGPU = currOceanVB->GetResource();
 }
 
 void LightningWavesApp::BuildLandGeometry()
 {
-	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 50, 50);
+	const float landSize = 160.0f;
+	const int landGridSize = 50;
+
+	MeshCache& meshCache = MeshCache::Get();
+	std::shared_ptr<const GeometryGenerator::MeshData> grid = meshCache.CreateGrid(landSize, landSize, landGridSize, landGridSize);
 
 	// Extract the vertex elements we are interested and apply the height function to
 	// each vertex. In addition, color the vertices based on their height so we have
 	// sandy looking beaches, grassy low hills and snow mountain peaks.
 
-	std::vector<LightningVertex> vertices(grid.Vertices.size());
-	for (size_t i = 0; i < grid.Vertices.size(); ++i)
+	std::vector<LightningVertex> vertices(grid->Vertices.size());
+	for (size_t i = 0; i < grid->Vertices.size(); ++i)
 	{
-		auto& p = grid.Vertices[i].Position;
+		auto& p = grid->Vertices[i].Position;
 		vertices[i].Pos = p;
 		vertices[i].Pos.y = GetHillsHeight(p.x, p.z);
 		vertices[i].Normal = GetHillsNormal(p.x, p.z);
 	}
 
+	// Keep the heights as a height field, so queries against the land match the mesh that is rendered
+	m_LandHeights.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+		m_LandHeights[i] = vertices[i].Pos.y;
+
+	m_LandHeightField.Heights = m_LandHeights.data();
+	m_LandHeightField.NumRows = landGridSize;
+	m_LandHeightField.NumColumns = landGridSize;
+	m_LandHeightField.OriginX = -0.5f * landSize;
+	m_LandHeightField.OriginZ = 0.5f * landSize;
+	m_LandHeightField.CellSizeX = landSize / (landGridSize - 1);
+	m_LandHeightField.CellSizeZ = landSize / (landGridSize - 1);
+
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(LightningVertex);
 
-	std::vector<uint16_t> indices = grid.GetIndices16();
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
+	// 16 bit indices while the land has at most 64K vertices, 32 bit ones past that
+	IndexData indices(grid->Indices32.data(), grid->Indices32.size());
+	const UINT ibByteSize = (UINT)indices.GetByteSize();
 
 	std::unique_ptr<MeshGeometry> geometry = std::make_unique<MeshGeometry>();
 	geometry->Name = "landGeo";
@@ -433,21 +561,21 @@ void LightningWavesApp::BuildLandGeometry()
 	CopyMemory(geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geometry->IndexBufferCPU));
-	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.GetData(), ibByteSize);
 
 	geometry->VertexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(),
 		m_CommandList.Get(), vertices.data(), vbByteSize, geometry->VertexBufferUploader);
 
 	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(),
-		m_CommandList.Get(), indices.data(), ibByteSize, geometry->IndexBufferUploader);
+		m_CommandList.Get(), indices.GetData(), ibByteSize, geometry->IndexBufferUploader);
 
 	geometry->VertexByteStride = sizeof(LightningVertex);
 	geometry->VertexBufferByteSize = vbByteSize;
-	geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geometry->IndexFormat = indices.GetFormat();
 	geometry->IndexBufferByteSize = ibByteSize;
 
 	SubMeshGeometry subMesh;
-	subMesh.IndexCount = (UINT)indices.size();
+	subMesh.IndexCount = (UINT)indices.GetCount();
 	subMesh.StartIndexLocation = 0;
 	subMesh.BaseVertexLocation = 0;
 
@@ -456,61 +584,96 @@ void LightningWavesApp::BuildLandGeometry()
 	m_Geometries["landGeo"] = std::move(geometry);
 }
 
-void LightningWavesApp::BuildWavesGeometryBuffers()
+// Fills in the indices of quadRowCount rows of quads of a grid with columnCount vertices per row.
+static std::vector<uint32_t> BuildGridIndices(int quadRowCount, int columnCount)
 {
-	std::vector<uint16_t> indices(3 * m_Waves->GetTriangleCount()); // 3 indices per face
-	assert(m_Waves->GetVertexCount() < 0x0000ffff);
-
-	// ITerate over each quad
-	int rowCount = m_Waves->GetRowCount();
-	int columnCount = m_Waves->GetColumnCount();
+	std::vector<uint32_t> indices(quadRowCount * (columnCount - 1) * 6); // 3 indices per face
 	int k = 0;
 
-	for (int row = 0; row < rowCount - 1; ++row)
+	// Iterate over each quad
+	for (int row = 0; row < quadRowCount; ++row)
 	{
 		for (int column = 0; column < columnCount - 1; ++column)
 		{
-			indices[k] = row * rowCount + column;
-			indices[k + 1] = row * rowCount + column + 1;
-			indices[k + 2] = (row + 1)*rowCount + column;
+			indices[k] = row * columnCount + column;
+			indices[k + 1] = row * columnCount + column + 1;
+			indices[k + 2] = (row + 1)*columnCount + column;
 
-			indices[k + 3] = (row + 1)*rowCount + column;
-			indices[k + 4] = row * rowCount + column + 1;
-			indices[k + 5] = (row + 1)*rowCount + column + 1;
+			indices[k + 3] = (row + 1)*columnCount + column;
+			indices[k + 4] = row * columnCount + column + 1;
+			indices[k + 5] = (row + 1)*columnCount + column + 1;
 
 			k += 6; // next quad
 		}
 	}
 
-	UINT vbByteSize = m_Waves->GetVertexCount() * sizeof(LightningVertex);
-	UINT ibByteSize = (UINT)indices.size() * sizeof(uint16_t);
+	return indices;
+}
+
+void LightningWavesApp::BuildWavesGeometryBuffers()
+{
+	m_WavesPatchCount = this->BuildWaterGeometryBuffers("waterGeo", *m_Waves);
+	m_OceanPatchCount = this->BuildWaterGeometryBuffers("oceanGeo", *m_Ocean);
+}
+
+int LightningWavesApp::BuildWaterGeometryBuffers(const std::string& geometryName, const WaterSurface& surface)
+{
+	int rowCount = surface.GetRowCount();
+	int columnCount = surface.GetColumnCount();
+	int quadRowCount = rowCount - 1;
+
+	// A 16-bit index can only address 64K vertices, about a 255x255 grid. Instead of switching the whole
+	// grid to 32-bit indices (2x the index memory), we split it in patches: bands of full rows
+	// of at most 64K vertices. Relative to its first vertex every patch has the same layout,
+	// so all patches share one index list and only differ in BaseVertexLocation.
+	// Only grids too wide for a single row of quads to fit in a patch need 32-bit indices,
+	// the patch is then the whole grid and IndexData keeps the indices in 32 bits.
+	int quadRowsPerPatch = std::min<int>(0x10000 / columnCount - 1, quadRowCount);
+	if (quadRowsPerPatch < 1)
+		quadRowsPerPatch = quadRowCount;
 
 	std::unique_ptr<MeshGeometry> geometry = std::make_unique<MeshGeometry>();
-	geometry->Name = "waterGeo";
+	geometry->Name = geometryName;
 
-	// Set dynamically
-	geometry->VertexBufferCPU = nullptr;
-	geometry->VertexBufferGPU = nullptr;
+	IndexData indices(BuildGridIndices(quadRowsPerPatch, columnCount));
+	UINT indexCount = (UINT)indices.GetCount();
+	UINT ibByteSize = (UINT)indices.GetByteSize();
 
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geometry->IndexBufferCPU));
-	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	CopyMemory(geometry->IndexBufferCPU->GetBufferPointer(), indices.GetData(), ibByteSize);
 
 	geometry->IndexBufferGPU = CreateDefaultBuffer(m_pDevice.Get(),
-		m_CommandList.Get(), indices.data(), ibByteSize, geometry->IndexBufferUploader);
+		m_CommandList.Get(), indices.GetData(), ibByteSize, geometry->IndexBufferUploader);
+	geometry->IndexFormat = indices.GetFormat();
+
+	UINT vbByteSize = surface.GetVertexCount() * sizeof(LightningVertex);
+
+	// Set dynamically
+	geometry->VertexBufferCPU = nullptr;
+	geometry->VertexBufferGPU = nullptr;
 
 	geometry->VertexByteStride = sizeof(LightningVertex);
 	geometry->VertexBufferByteSize = vbByteSize;
-	geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geometry->IndexBufferByteSize = ibByteSize;
 
-	SubMeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
-	submesh.StartIndexLocation = 0;
-	submesh.BaseVertexLocation = 0;
+	// The rows are in order in the index list, so the last (shorter) patch just draws fewer of them
+	UINT indicesPerQuadRow = indexCount / quadRowsPerPatch;
+	int patchCount = (quadRowCount + quadRowsPerPatch - 1) / quadRowsPerPatch;
 
-	geometry->DrawArgs["grid"] = submesh;
+	for (int patch = 0; patch < patchCount; ++patch)
+	{
+		int firstQuadRow = patch * quadRowsPerPatch;
+
+		SubMeshGeometry submesh;
+		submesh.IndexCount = std::min<int>(quadRowsPerPatch, quadRowCount - firstQuadRow) * indicesPerQuadRow;
+		submesh.StartIndexLocation = 0;
+		submesh.BaseVertexLocation = firstQuadRow * columnCount;
+
+		geometry->DrawArgs["grid" + std::to_string(patch)] = submesh;
+	}
 
-	m_Geometries["waterGeo"] = std::move(geometry);
+	m_Geometries[geometryName] = std::move(geometry);
+	return patchCount;
 }
 
 float LightningWavesApp::GetHillsHeight(float x, float z)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "1.0 Core/D3DAppBase.h"
+#include "1.0 Core/OceanEngine.h"
+#include "1.0 Core/WaterSimulationManager.h"
 #include "LightningWaves.h"
 
 class LightningWavesApp : public D3DAppBase
@@ -29,9 +31,16 @@ private:
 	void BuildLandGeometry();
 	void BuildWavesGeometryBuffers();
 
+	// Builds the index buffer and the draw args of a water body whose vertices are written per frame,
+	// returns the number of patches ("grid0", "grid1", ...) the grid is drawn in.
+	int BuildWaterGeometryBuffers(const std::string& geometryName, const WaterSurface& surface);
+
 	void OnKeyboardInput(const GameTimer& gt);
 	void UpdateWaves(const GameTimer& gt);
 
+	// Shows what the last key press did in the title of the window
+	void ShowStatus(const std::wstring& status);
+
 	float GetHillsHeight(float x, float z);
 	DirectX::XMFLOAT3 GetHillsNormal(float x, float z);
 
@@ -41,8 +50,26 @@ private:
 
 	std::array<D3D12_INPUT_ELEMENT_DESC, 2> m_InputLayout;
 
-	std::unique_ptr<LightningWaves> m_Waves;
+	// Owns and steps the water bodies of the scene, m_Waves is the lake and m_Ocean the sea around the land
+	WaterSimulationManager m_WaterSimulation;
+	LightningWaves* m_Waves = nullptr;
+	int m_WavesBody = -1;
 	RenderItem* m_WavesRenderItem = nullptr;
+	int m_WavesPatchCount = 0;
+
+	OceanEngine<LightningVertex>* m_Ocean = nullptr;
+	int m_OceanBody = -1;
+	RenderItem* m_OceanRenderItem = nullptr;
+	int m_OceanPatchCount = 0;
+
+	// Whether the keys were down last frame, to act once per press
+	bool m_TiledModeKeyDown = false;
+	bool m_SaveKeyDown = false;
+	bool m_RestoreKeyDown = false;
+
+	// The land baked to a grid, for batched height/normal queries with SampleHeightField (see UpdateWaves)
+	std::vector<float> m_LandHeights;
+	HeightFieldView m_LandHeightField;
 
 	float m_SunTheta = 1.25f * DirectX::XM_PI;
 	float m_SunPhi = DirectX::XM_PIDIV4;